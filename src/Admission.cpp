@@ -0,0 +1,165 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "Admission.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QThread>
+#pragma pop_macro("new")
+
+#if defined(Q_OS_WIN)
+   #include <windows.h>
+#else
+   #include <time.h>
+#endif
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//!
+//! \brief Takes a slot of the endpoint.
+//! If all slots are taken and fewer than #maxQueued requests wait, the
+//! request waits up to #queueTimeout milliseconds on its worker thread.
+//!
+//! \returns bool  If the request got a slot.
+//!
+//*****************************************************************************
+bool AdmissionGate::Enter()
+{
+   QMutexLocker lock(&mutex);
+   if (running < maxConcurrent) {
+      running++;
+      return true;
+   }
+   if (waiting >= maxQueued)
+      return false;
+
+   waiting++;
+   QDeadlineTimer deadline(queueTimeout);
+   while (running >= maxConcurrent) {
+      if (!freed.wait(&mutex, deadline))
+         break;
+   }
+   waiting--;
+
+   if (running >= maxConcurrent)
+      return false;
+   running++;
+   return true;
+}
+
+void AdmissionGate::Leave()
+{
+   QMutexLocker lock(&mutex);
+   running--;
+   freed.wakeOne();
+}
+
+//*****************************************************************************
+//!
+//! \brief Checks the load of the server.
+//! The thread that finds the sample interval expired takes the sample, the
+//! others read the result of the last one without waiting.
+//!
+//! \returns bool  If the server is overloaded.
+//!
+//*****************************************************************************
+bool LoadShedder::Overloaded()
+{
+   if (options.maxCpuLoad <= 0 && options.maxLatency <= 0)
+      return false;
+
+   Clock::time_point now = Clock::now();
+   Clock::rep next = nextSample.load(std::memory_order_relaxed);
+   if (now.time_since_epoch().count() >= next
+       && nextSample.compare_exchange_strong(next, (now + sampleInterval).time_since_epoch().count(), std::memory_order_relaxed))
+      Sample(now);
+
+   return overloaded.load(std::memory_order_relaxed);
+}
+
+void LoadShedder::Record(Clock::duration latency)
+{
+   windowNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(), std::memory_order_relaxed);
+   windowRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+//*****************************************************************************
+//!
+//! \brief Samples CPU load and latency since the last sample.
+//! The CPU load is the CPU time of the process per core. The latency is the
+//! average of the requests processed since the last sample, so it drops to
+//! zero if everything is shed.
+//!
+//*****************************************************************************
+void LoadShedder::Sample(Clock::time_point now)
+{
+   qint64 cpuTime = ProcessCpuTime();
+   if (lastSample != Clock::time_point()) {
+      qint64 wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastSample).count() * qMax(1, QThread::idealThreadCount());
+      cpuLoad.store(wall > 0 ? int((cpuTime - lastCpuTime) * 1000 / wall) : 0, std::memory_order_relaxed);
+   }
+   lastSample = now;
+   lastCpuTime = cpuTime;
+
+   qint64 nanoseconds = windowNanoseconds.exchange(0, std::memory_order_relaxed);
+   quint64 requests = windowRequests.exchange(0, std::memory_order_relaxed);
+   latency.store(requests ? nanoseconds / qint64(requests) : 0, std::memory_order_relaxed);
+
+   bool cpuExceeded = options.maxCpuLoad > 0 && cpuLoad.load(std::memory_order_relaxed) > int(options.maxCpuLoad * 1000);
+   bool latencyExceeded = options.maxLatency > 0 && latency.load(std::memory_order_relaxed) > qint64(options.maxLatency) * 1000000;
+   overloaded.store(cpuExceeded || latencyExceeded, std::memory_order_relaxed);
+}
+
+//*****************************************************************************
+//! CPU time of all threads of the process in nanoseconds.
+//*****************************************************************************
+qint64 LoadShedder::ProcessCpuTime()
+{
+#if defined(Q_OS_WIN)
+   FILETIME creation, exit, kernel, user;
+   if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+      return 0;
+   auto ticks = [](const FILETIME& time) { return (qint64(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+   return (ticks(kernel) + ticks(user)) * 100;   // 100 ns ticks
+#else
+   timespec time;
+   if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+      return 0;
+   return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+void LoadShedder::Collect(HttpServer::Metrics& metrics) const
+{
+   metrics.shedding.cpuLoad = double(cpuLoad.load(std::memory_order_relaxed)) / 1000.0;
+   metrics.shedding.latency = double(latency.load(std::memory_order_relaxed)) / 1e9;
+   metrics.shedding.overloaded = overloaded.load(std::memory_order_relaxed);
+   metrics.shedding.shed = shed.load(std::memory_order_relaxed);
+}
+
+}
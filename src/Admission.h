@@ -0,0 +1,135 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_ADMISSION__H
+#define MAU_ADMISSION__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <chrono>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Admission control of the requests to callback endpoints.
+//!
+//! An AdmissionGate limits the requests of one endpoint that are processed
+//! at a time. A few more may wait for a slot, the others are refused right
+//! away, so a slow endpoint can't take every worker thread.
+//!
+//! The LoadShedder watches the whole server. If the process uses too much
+//! CPU time or the recent requests took too long, requests to endpoints that
+//! aren't critical are refused until the load drops.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class AdmissionGate
+{
+public:
+   AdmissionGate(int maxConcurrent, int maxQueued, int queueTimeout) : maxConcurrent(maxConcurrent), maxQueued(maxQueued), queueTimeout(queueTimeout) {}
+   AdmissionGate(const AdmissionGate&) = delete;
+   AdmissionGate& operator=(const AdmissionGate&) = delete;
+
+   bool Enter();
+      //!< \brief Takes a slot, waiting for one if the queue has room.
+      //!< \return False if the request is refused. Otherwise call Leave() when it is processed.
+
+   void Leave();
+      //!< \brief Frees the slot of a request.
+
+   class Slot {
+      //!< \brief Frees the slot taken with Enter() when it goes out of scope.
+   public:
+      explicit Slot(AdmissionGate* gate) : gate(gate) {}
+      Slot(const Slot&) = delete;
+      Slot& operator=(const Slot&) = delete;
+      ~Slot() { if (gate) gate->Leave(); }
+   private:
+      AdmissionGate* gate;
+   };
+
+private:
+   QMutex mutex;
+   QWaitCondition freed;
+   int running = 0;
+   int waiting = 0;
+   const int maxConcurrent;
+   const int maxQueued;
+   const int queueTimeout;
+};
+
+class LoadShedder
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   void Options(const HttpServer::SheddingOptions& options) { LoadShedder::options = options; }
+      //!< \brief Sets the limits. Not thread-safe, set them while the server is stopped.
+   HttpServer::SheddingOptions Options() const { return options; }
+
+   bool Overloaded();
+      //!< \brief If requests to endpoints that aren't critical should be refused.
+      //!< Samples the load at most every #sampleInterval, otherwise just reads it.
+
+   void Record(Clock::duration latency);
+      //!< \brief Adds the latency of a processed request to the current sample.
+
+   void Shed() { shed.fetch_add(1, std::memory_order_relaxed); }
+      //!< \brief Counts a refused request.
+
+   void Collect(HttpServer::Metrics& metrics) const;
+      //!< \brief Copies the load and the refused requests into #metrics.
+
+private:
+   static constexpr Clock::duration sampleInterval = std::chrono::milliseconds(250);
+
+   void Sample(Clock::time_point now);
+   static qint64 ProcessCpuTime();
+
+   HttpServer::SheddingOptions options;
+   std::atomic<Clock::rep> nextSample{ 0 };      //!< When the load is sampled next, in ticks of #Clock
+   Clock::time_point lastSample;                 //!< Written by the sampling thread only
+   qint64 lastCpuTime = 0;                       //!< Written by the sampling thread only
+   std::atomic<qint64> windowNanoseconds{ 0 };   //!< Latency of the requests of the current sample
+   std::atomic<quint64> windowRequests{ 0 };
+   std::atomic<int> cpuLoad{ 0 };                //!< CPU time of the last sample per core, in per mille
+   std::atomic<qint64> latency{ 0 };             //!< Average latency of the last sample in nanoseconds
+   std::atomic<bool> overloaded{ false };
+   std::atomic<quint64> shed{ 0 };
+};
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "Compression.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QElapsedTimer>
+#pragma pop_macro("new")
+
+#include <limits>
+#include <string>
+
+#include <zlib.h>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//!
+//! \brief Picks the content coding for an Accept-Encoding header value.
+//! The coding with the highest quality value wins, gzip before deflate on
+//! equal values. Codings with a quality value of 0 are refused.
+//!
+//! \param   acceptEncoding Value of the Accept-Encoding header.
+//! \returns QByteArray     The content coding, empty for identity.
+//!
+//*****************************************************************************
+QByteArray Compression::Negotiate(std::string_view acceptEncoding)
+{
+   auto trim = [](std::string_view value) {
+      while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+         value.remove_prefix(1);
+      while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+         value.remove_suffix(1);
+      return value;
+   };
+
+   double gzip = 0.0, deflate = 0.0, any = -1.0;
+   bool gzipListed = false, deflateListed = false;
+
+   while (!acceptEncoding.empty()) {
+      std::string_view::size_type end = acceptEncoding.find(',');
+      std::string_view coding = acceptEncoding.substr(0, end);
+      acceptEncoding = end == std::string_view::npos ? std::string_view() : acceptEncoding.substr(end + 1);
+
+      double quality = 1.0;
+      std::string_view::size_type parameters = coding.find(';');
+      if (parameters != std::string_view::npos) {
+         std::string_view q = trim(coding.substr(parameters + 1));
+         if (q.substr(0, 2) == "q=" || q.substr(0, 2) == "Q=")
+            quality = QByteArray(q.data() + 2, qsizetype(q.size() - 2)).toDouble();
+         coding = coding.substr(0, parameters);
+      }
+      coding = trim(coding);
+
+      if (QByteArrayView(coding.data(), coding.size()).compare("gzip", Qt::CaseInsensitive) == 0
+          || QByteArrayView(coding.data(), coding.size()).compare("x-gzip", Qt::CaseInsensitive) == 0) {
+         gzip = quality;
+         gzipListed = true;
+      } else if (QByteArrayView(coding.data(), coding.size()).compare("deflate", Qt::CaseInsensitive) == 0) {
+         deflate = quality;
+         deflateListed = true;
+      } else if (coding == "*") {
+         any = quality;
+      }
+   }
+
+   if (any >= 0.0) {
+      if (!gzipListed)
+         gzip = any;
+      if (!deflateListed)
+         deflate = any;
+   }
+
+   if (gzip > 0.0 && gzip >= deflate)
+      return "gzip";
+   if (deflate > 0.0)
+      return "deflate";
+   return QByteArray();
+}
+
+//*****************************************************************************
+//!
+//! \brief Compresses data.
+//! The deflate coding is the zlib format, as RFC 9110, 8.4.1.2 requires.
+//!
+//! \param   encoding     The content coding, "gzip" or "deflate".
+//! \param   level        zlib compression level, 1 (fastest) to 9 (best).
+//! \param   data         Data to compress.
+//! \returns SharedBuffer The compressed data, or null on error.
+//!
+//*****************************************************************************
+HttpServer::SharedBuffer Compression::Compress(const QByteArray& encoding, int level, QByteArrayView data)
+{
+   QElapsedTimer timer;
+   timer.start();
+
+   z_stream stream = {};
+   int windowBits = encoding == "gzip" ? MAX_WBITS + 16 : MAX_WBITS;   // +16 writes a gzip header and trailer
+   if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+      return nullptr;
+
+   // zlib counts in uInt, so bodies above 4 GB are fed and drained in chunks
+   constexpr qsizetype maxChunk = std::numeric_limits<uInt>::max();
+   std::string compressed;
+   compressed.resize(deflateBound(&stream, uLong(qMin(data.size(), maxChunk))) + 18);   // deflateBound() doesn't include the gzip wrapper
+
+   const char* input = data.data();
+   qsizetype remaining = data.size();
+   size_t used = 0;
+   int result = Z_OK;
+   while (result == Z_OK) {
+      if (stream.avail_in == 0) {
+         uInt chunk = uInt(qMin(remaining, maxChunk));
+         stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+         stream.avail_in = chunk;
+         input     += chunk;
+         remaining -= chunk;
+      }
+      if (used == compressed.size())
+         compressed.resize(compressed.size() * 2);
+
+      uInt space = uInt(qMin(compressed.size() - used, size_t(maxChunk)));
+      stream.next_out  = reinterpret_cast<Bytef*>(compressed.data() + used);
+      stream.avail_out = space;
+      result = deflate(&stream, remaining > 0 ? Z_NO_FLUSH : Z_FINISH);
+      used += space - stream.avail_out;
+   }
+   compressed.resize(used);
+   deflateEnd(&stream);
+   if (result != Z_STREAM_END)
+      return nullptr;
+
+   bodies.fetch_add(1, std::memory_order_relaxed);
+   bytesIn.fetch_add(quint64(data.size()), std::memory_order_relaxed);
+   bytesOut.fetch_add(quint64(compressed.size()), std::memory_order_relaxed);
+   wallNanoseconds.fetch_add(quint64(timer.nsecsElapsed()), std::memory_order_relaxed);
+
+   return std::make_shared<const std::string>(std::move(compressed));
+}
+
+HttpServer::CompressionStatistics Compression::Statistics() const
+{
+   HttpServer::CompressionStatistics statistics;
+   statistics.bodies          = bodies.load(std::memory_order_relaxed);
+   statistics.bytesIn         = bytesIn.load(std::memory_order_relaxed);
+   statistics.bytesOut        = bytesOut.load(std::memory_order_relaxed);
+   statistics.wallNanoseconds = wallNanoseconds.load(std::memory_order_relaxed);
+   return statistics;
+}
+
+}
@@ -0,0 +1,76 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_COMPRESSION__H
+#define MAU_COMPRESSION__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <string_view>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Content coding of response bodies.
+//!
+//! Supports the gzip and deflate codings of RFC 9110, 8.4.1 with zlib and
+//! counts the bytes and wall-clock time spent on compression.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class Compression
+{
+public:
+   static QByteArray Negotiate(std::string_view acceptEncoding);
+      //!< \brief Picks the content coding for an Accept-Encoding header value.
+      //!< \return "gzip", "deflate" or an empty array if the body isn't compressed.
+
+   HttpServer::SharedBuffer Compress(const QByteArray& encoding, int level, QByteArrayView data);
+      //!< \brief Compresses #data with the content coding #encoding.
+      //!< \return The compressed data, or null on error.
+
+   HttpServer::CompressionStatistics Statistics() const;
+      //!< \brief Counters of all compressions so far.
+
+private:
+   std::atomic<quint64> bodies{ 0 };
+   std::atomic<quint64> bytesIn{ 0 };
+   std::atomic<quint64> bytesOut{ 0 };
+   std::atomic<quint64> wallNanoseconds{ 0 };
+};
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "EventStream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//! Queues an event. A client that doesn't keep up is dropped instead of
+//! queuing without bound, EventSource clients reconnect on their own.
+//*****************************************************************************
+bool EventSubscription::Push(const HttpServer::SharedBuffer& event)
+{
+   QMutexLocker lock(&mutex);
+   if (closed)
+      return false;
+
+   if (queue.size() >= maxQueued) {
+      closed = true;
+      queue.clear();
+   } else {
+      queue.push_back(event);
+   }
+   ready.wakeOne();
+   return !closed;
+}
+
+//*****************************************************************************
+//! Waits for events and takes all queued ones, so a burst is written with one
+//! write. Called on a server thread while the response is written.
+//*****************************************************************************
+std::vector<HttpServer::SharedBuffer> EventSubscription::Next(int timeout, bool& ended)
+{
+   QMutexLocker lock(&mutex);
+   if (queue.empty() && !closed)
+      ready.wait(&mutex, timeout);
+
+   ended = closed;
+   std::vector<HttpServer::SharedBuffer> events;
+   if (ended)
+      return events;
+
+   events.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+   queue.clear();
+   return events;
+}
+
+void EventSubscription::Close()
+{
+   QMutexLocker lock(&mutex);
+   closed = true;
+   queue.clear();
+   ready.wakeOne();
+}
+
+bool EventSubscription::IsClosed() const
+{
+   QMutexLocker lock(&mutex);
+   return closed;
+}
+
+//*****************************************************************************
+//! Adds a subscriber if the channel isn't full. Closed subscriptions don't count.
+//*****************************************************************************
+std::shared_ptr<EventSubscription> EventChannel::Subscribe()
+{
+   QMutexLocker lock(&mutex);
+   subscriptions.removeIf([](const std::shared_ptr<EventSubscription>& subscription) { return subscription->IsClosed(); });
+   if (!open || subscriptions.size() >= maxSubscribers)
+      return nullptr;
+
+   auto subscription = std::make_shared<EventSubscription>();
+   subscriptions.append(subscription);
+   return subscription;
+}
+
+int EventChannel::Subscribers() const
+{
+   QMutexLocker lock(&mutex);
+   return int(std::count_if(subscriptions.begin(), subscriptions.end(), [](const std::shared_ptr<EventSubscription>& subscription) { return !subscription->IsClosed(); }));
+}
+
+//*****************************************************************************
+//! Queues an event for every subscriber and drops the closed subscriptions.
+//*****************************************************************************
+int EventChannel::Publish(const HttpServer::SharedBuffer& event)
+{
+   QMutexLocker lock(&mutex);
+   int queued = 0;
+   subscriptions.removeIf([&](const std::shared_ptr<EventSubscription>& subscription) {
+      if (!subscription->Push(event))
+         return true;
+      queued++;
+      return false;
+   });
+   return queued;
+}
+
+void EventChannel::Open()
+{
+   QMutexLocker lock(&mutex);
+   open = true;
+}
+
+//*****************************************************************************
+//! Ends the responses of all subscribers, so the server threads writing them
+//! are released.
+//*****************************************************************************
+void EventChannel::Close()
+{
+   QMutexLocker lock(&mutex);
+   open = false;
+   for (const std::shared_ptr<EventSubscription>& subscription : subscriptions)
+      subscription->Close();
+   subscriptions.clear();
+}
+
+//*****************************************************************************
+//!
+//! \brief Formats an event in the text/event-stream format.
+//! Every line of #data becomes a data field. Line breaks in #event and #id
+//! would end the field, they are removed.
+//!
+//! \param   data   Payload of the event.
+//! \param   event  Event type, empty for the default type "message".
+//! \param   id     Event ID, empty for none.
+//! \returns The event, framed as one chunk.
+//!
+//*****************************************************************************
+HttpServer::SharedBuffer EventChannel::Serialize(const QByteArray& data, const QString& event, const QString& id)
+{
+   auto field = [](const QString& value) {
+      QByteArray utf8 = value.toUtf8();
+      utf8.replace('\r', QByteArray()).replace('\n', QByteArray());
+      return utf8.toStdString();
+   };
+
+   std::string text;
+   text.reserve(data.size() + 64);
+   if (!id.isEmpty())
+      text += "id: " + field(id) + '\n';
+   if (!event.isEmpty())
+      text += "event: " + field(event) + '\n';
+
+   QByteArray normalized = data;
+   normalized.replace("\r\n", "\n").replace('\r', '\n');
+   for (const QByteArray& line : normalized.split('\n')) {
+      text += "data: ";
+      text.append(line.constData(), std::size_t(line.size()));
+      text += '\n';
+   }
+   text += '\n';
+
+   return Chunk(text);
+}
+
+HttpServer::SharedBuffer EventChannel::Chunk(const std::string& text)
+{
+   char header[20];
+   int headerSize = std::snprintf(header, sizeof(header), "%llx\r\n", static_cast<unsigned long long>(text.size()));
+
+   auto chunk = std::make_shared<std::string>();
+   chunk->reserve(std::size_t(headerSize) + text.size() + 2);
+   chunk->append(header, std::size_t(headerSize));
+   chunk->append(text);
+   chunk->append("\r\n");
+   return chunk;
+}
+
+}
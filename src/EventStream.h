@@ -0,0 +1,124 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_EVENTSTREAM__H
+#define MAU_EVENTSTREAM__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#pragma pop_macro("new")
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Server-Sent Events of an event endpoint.
+//!
+//! An event is serialized once into a shared buffer that already is a
+//! complete chunk of the chunked transfer encoding. Every subscription
+//! queues a reference to it, so publishing to many clients never copies
+//! the event. The events queued while a subscriber's stream was written are
+//! taken as one batch.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class EventSubscription
+{
+public:
+   static const int maxQueued = 256;            //!< Events queued for a slow client before it is dropped
+
+   bool Push(const HttpServer::SharedBuffer& event);
+      //!< \brief Queues #event. Closes the subscription if too many events are queued.
+      //!< \return False if the subscription is closed.
+
+   std::vector<HttpServer::SharedBuffer> Next(int timeout, bool& ended);
+      //!< \brief Waits up to #timeout milliseconds for events.
+      //!< \return All queued events, empty on timeout or if #ended is set.
+
+   void Close();
+      //!< \brief Ends the subscription, Next() returns right away.
+
+   bool IsClosed() const;
+
+private:
+   mutable QMutex mutex;
+   QWaitCondition ready;
+   std::deque<HttpServer::SharedBuffer> queue;
+   bool closed = false;
+};
+
+class EventChannel
+{
+public:
+   explicit EventChannel(int maxSubscribers) : maxSubscribers(maxSubscribers) {}
+
+   int MaxSubscribers() const { return maxSubscribers; }
+
+   int Subscribers() const;
+      //!< \brief Number of subscriptions that aren't closed yet.
+
+   std::shared_ptr<EventSubscription> Subscribe();
+      //!< \brief Adds a subscriber.
+      //!< \return The subscription, or null if the channel is closed or has #maxSubscribers already.
+
+   int Publish(const HttpServer::SharedBuffer& event);
+      //!< \brief Queues #event for every subscriber.
+      //!< \return The number of subscribers the event was queued for.
+
+   void Open();
+      //!< \brief Accepts subscribers again after Close().
+
+   void Close();
+      //!< \brief Closes all subscriptions and refuses new subscribers until Open().
+
+   static HttpServer::SharedBuffer Serialize(const QByteArray& data, const QString& event, const QString& id);
+      //!< \brief Formats an event as text/event-stream, framed as one chunk.
+
+   static HttpServer::SharedBuffer Chunk(const std::string& text);
+      //!< \brief Frames #text as one chunk of the chunked transfer encoding.
+
+private:
+   mutable QMutex mutex;
+   QList<std::shared_ptr<EventSubscription>> subscriptions;
+   int maxSubscribers;
+   bool open = true;
+};
+
+}
+
+#endif
@@ -21,13 +21,21 @@
 #include "Global.h"
 #include "Exception.h"
 
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QDebug>
+#pragma pop_macro("new")
+
 #include <algorithm>
+#include <atomic>
 
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
 
 namespace mau {
 
+static std::atomic<quint64> loggedCount[2] = {};   // Indexed by Exception::Severities
+
 Exception::Exception(const QString& id, Exception::Severities severity, const EventMsg& msg):
    id(id), severity(severity), msg(msg),
    file(""), line(0)
@@ -75,12 +83,33 @@ Exception& Exception::Location(const QString& file, int line)
    return *this;
 }
 
+//*****************************************************************************
+//!
+//! \brief Logs the exception through the Qt message handler.
+//! Warnings are logged with qWarning(), errors with qCritical(). The logged
+//! exceptions are counted, see Logged().
+//!
+//*****************************************************************************
 Exception& Exception::Log()
 {
-   // TODO
+   loggedCount[severity == warning ? 0 : 1].fetch_add(1, std::memory_order_relaxed);
+
+   QByteArray fileName = file.toUtf8();
+   QMessageLogger logger(fileName.constData(), line, nullptr);
+   QString text = Msg().value("en-US");
+   if (severity == warning)
+      logger.warning().noquote() << id << text;
+   else
+      logger.critical().noquote() << id << text;
+
    return *this;
 }
 
+quint64 Exception::Logged(Exception::Severities severity)
+{
+   return loggedCount[severity == warning ? 0 : 1].load(std::memory_order_relaxed);
+}
+
 Exception* Exception::Duplicate()
 {
    return new Exception(*this);
@@ -74,6 +74,9 @@ public:
    int Line() const { return line; }
    EventMsg Msg() const;
 
+   static quint64 Logged(Severities severity);
+      //!< \brief Number of exceptions of #severity logged with Log() so far.
+
 protected:
    QString id;
    Severities severity;
@@ -21,10 +21,14 @@
 #ifndef MAU_GLOBAL__H
 #define MAU_GLOBAL__H
 
-#ifdef MAUCPPHTTPSERVER_DLL
-#define MAUCPPHTTPSERVER_EXPORT __declspec(dllexport)
+#if defined(_WIN32)
+   #ifdef MAUCPPHTTPSERVER_DLL
+   #define MAUCPPHTTPSERVER_EXPORT __declspec(dllexport)
+   #else
+   #define MAUCPPHTTPSERVER_EXPORT __declspec(dllimport)
+   #endif
 #else
-#define MAUCPPHTTPSERVER_EXPORT __declspec(dllimport)
+   #define MAUCPPHTTPSERVER_EXPORT __attribute__((visibility("default")))
 #endif
 
 #endif
@@ -0,0 +1,362 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "HttpBodyWebcc.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QThread>
+#pragma pop_macro("new")
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+#include <boost/asio/buffer.hpp>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//! Constructors. The QByteArray is implicitly shared, not copied.
+//*****************************************************************************
+BufferBody::BufferBody(const QByteArray& buffer) :
+   bytes(buffer),
+   data(bytes.constData()),
+   size(bytes.size())
+{
+}
+
+BufferBody::BufferBody(HttpServer::SharedBuffer buffer) :
+   shared(std::move(buffer)),
+   data(shared->data()),
+   size(shared->size())
+{
+}
+
+//*****************************************************************************
+//! The whole buffer is sent as one payload.
+//*****************************************************************************
+webcc::Payload BufferBody::NextPayload(bool freePrevious)
+{
+   if (sent)
+      return {};
+
+   sent = true;
+   return { boost::asio::buffer(data, size) };
+}
+
+void BufferBody::Dump(std::ostream& os, std::string_view prefix) const
+{
+   os << prefix << "<" << size << " bytes>" << std::endl;
+}
+
+//*****************************************************************************
+//! Constructor. The context object is moved to the thread of the device.
+//*****************************************************************************
+DevicePump::DevicePump(std::shared_ptr<QIODevice> device, qint64 capacity) :
+   device(std::move(device)),
+   context(new QObject()),
+   capacity(capacity)
+{
+   context->moveToThread(DevicePump::device->thread());
+}
+
+//*****************************************************************************
+//!
+//! \brief Destructor.
+//! The device and the context object are released on the thread of the
+//! device, QObjects must not be destroyed on another thread.
+//!
+//*****************************************************************************
+DevicePump::~DevicePump()
+{
+   QMetaObject::invokeMethod(context, [device = std::move(device)]() mutable { device.reset(); }, Qt::QueuedConnection);
+   context->deleteLater();
+}
+
+void DevicePump::Start()
+{
+   std::weak_ptr<DevicePump> pump = weak_from_this();
+   auto fill = [pump]() {
+      if (std::shared_ptr<DevicePump> self = pump.lock())
+         self->Fill();
+   };
+   auto finish = [pump]() {
+      if (std::shared_ptr<DevicePump> self = pump.lock()) {
+         {
+            QMutexLocker lock(&self->mutex);
+            self->channelFinished = true;
+         }
+         self->Fill();
+      }
+   };
+
+   QObject::connect(device.get(), &QIODevice::readyRead, context, fill);
+   QObject::connect(device.get(), &QIODevice::readChannelFinished, context, finish);
+   QObject::connect(device.get(), &QIODevice::aboutToClose, context, finish);
+
+   pending = true;
+   QMetaObject::invokeMethod(context, fill, Qt::QueuedConnection);   // Data may have arrived before the connections were made
+}
+
+//*****************************************************************************
+//!
+//! \brief Reads the available data of the device into the buffer.
+//! Runs on the thread of the device. Stops when the buffer is full or the
+//! device has no data available, the next readyRead() continues.
+//!
+//*****************************************************************************
+void DevicePump::Fill()
+{
+   QMutexLocker lock(&mutex);
+   pending = false;
+
+   while (!ended && buffer.size() < capacity) {
+      qint64 room = capacity - buffer.size();
+      lock.unlock();
+      QByteArray data = device->read(room);
+      bool error = data.isEmpty() && !device->isOpen();
+      lock.relock();
+
+      if (error) {
+         ended = true;
+         failed = !channelFinished;   // Closed after the read channel finished is the regular end
+      } else if (data.isEmpty()) {
+         ended = channelFinished;
+         break;
+      } else {
+         buffer.append(data);
+      }
+   }
+
+   ready.wakeAll();
+}
+
+//*****************************************************************************
+//! Queues a Fill() on the thread of the device, unless one is pending.
+//*****************************************************************************
+void DevicePump::Refill()
+{
+   if (pending || ended)
+      return;
+
+   pending = true;
+   std::weak_ptr<DevicePump> pump = weak_from_this();
+   QMetaObject::invokeMethod(context, [pump]() {
+      if (std::shared_ptr<DevicePump> self = pump.lock())
+         self->Fill();
+   }, Qt::QueuedConnection);
+}
+
+qint64 DevicePump::Take(char* data, qint64 maxSize, int timeout)
+{
+   QMutexLocker lock(&mutex);
+   QDeadlineTimer deadline(timeout);
+   while (buffer.isEmpty() && !ended) {
+      if (!ready.wait(&mutex, deadline))
+         return -1;
+   }
+
+   if (buffer.isEmpty())
+      return failed ? -1 : 0;
+
+   qint64 size = qMin(maxSize, qint64(buffer.size()));
+   std::memcpy(data, buffer.constData(), std::size_t(size));
+   buffer.remove(0, size);
+   Refill();
+   return size;
+}
+
+//*****************************************************************************
+//!
+//! \brief Constructors.
+//! A sequential device is read by a DevicePump on its thread. Devices with
+//! random access, like files, have their data at hand and are read directly,
+//! as are sequential devices of a thread without an event loop, which
+//! couldn't deliver any data to a pump.
+//!
+//*****************************************************************************
+ProducerBody::ProducerBody(HttpServer::BodyProducer producer, qint64 contentLength, qint64 window) :
+   producer(std::move(producer)),
+   contentLength(contentLength),
+   window(window, Qt::Uninitialized)
+{
+}
+
+ProducerBody::ProducerBody(std::shared_ptr<QIODevice> device, qint64 contentLength, qint64 window, int readTimeout) :
+   device(std::move(device)),
+   contentLength(contentLength),
+   readTimeout(readTimeout),
+   window(window, Qt::Uninitialized)
+{
+   if (!ProducerBody::device->isSequential()) {
+      if (ProducerBody::contentLength < 0)
+         ProducerBody::contentLength = ProducerBody::device->size() - ProducerBody::device->pos();
+   } else if (ProducerBody::device->thread() && ProducerBody::device->thread()->eventDispatcher()) {
+      pump = std::make_shared<DevicePump>(std::move(ProducerBody::device), window);   // The pump releases it on its thread
+      pump->Start();
+   }
+}
+
+void ProducerBody::InitPayload()
+{
+   produced = 0;
+   finished = false;
+}
+
+//*****************************************************************************
+//!
+//! \brief Produces the next window of the body.
+//! Webcc asks for the next payload only after the previous one was written,
+//! so the window buffer is reused. With chunked transfer encoding every
+//! window is framed as one chunk and the last chunk has a size of zero.
+//!
+//*****************************************************************************
+webcc::Payload ProducerBody::NextPayload(bool freePrevious)
+{
+   static const char crlf[] = "\r\n";
+   static const char lastChunk[] = "0\r\n\r\n";
+
+   if (finished)
+      return {};
+
+   qint64 maxSize = window.size();
+   if (!IsChunked())
+      maxSize = qMin(maxSize, contentLength - produced);
+
+   qint64 size = maxSize > 0 ? Produce(window.data(), maxSize) : 0;
+   if (size <= 0) {
+      // A fixed size body ends when the content length is reached. If the
+      // producer fails or ends early, the response is cut short.
+      finished = true;
+      if (IsChunked() && size == 0)
+         return { boost::asio::buffer(lastChunk, sizeof(lastChunk) - 1) };
+      return {};
+   }
+
+   produced += size;
+   if (!IsChunked())
+      return { boost::asio::buffer(window.constData(), size) };
+
+   int headerSize = std::snprintf(chunkHeader, sizeof(chunkHeader), "%llx\r\n", static_cast<unsigned long long>(size));
+   return {
+      boost::asio::buffer(chunkHeader, headerSize),
+      boost::asio::buffer(window.constData(), size),
+      boost::asio::buffer(crlf, sizeof(crlf) - 1)
+   };
+}
+
+//*****************************************************************************
+//!
+//! \brief Reads from the producer, the pump or the device.
+//! Webcc has no way to resume a body later, so while the pump has no data
+//! the loop thread waits for it, at most until the read timeout. Every
+//! connection of the loop waits with it, so a device that stalls longer
+//! cuts the body short.
+//!
+//*****************************************************************************
+qint64 ProducerBody::Produce(char* data, qint64 maxSize)
+{
+   if (producer)
+      return producer(data, maxSize);
+   if (pump)
+      return pump->Take(data, maxSize, readTimeout);
+
+   // A sequential device of a thread without an event loop has no other thread driving it.
+   qint64 size = device->read(data, maxSize);
+   while (size == 0 && !device->atEnd() && device->waitForReadyRead(readTimeout))
+      size = device->read(data, maxSize);
+   return size;
+}
+
+void ProducerBody::Dump(std::ostream& os, std::string_view prefix) const
+{
+   if (IsChunked())
+      os << prefix << "<chunked>" << std::endl;
+   else
+      os << prefix << "<" << contentLength << " bytes>" << std::endl;
+}
+
+//*****************************************************************************
+//! Constructor and destructor. Destroying the body ends the subscription.
+//*****************************************************************************
+EventStreamBody::EventStreamBody(std::shared_ptr<EventSubscription> subscription) :
+   subscription(std::move(subscription))
+{
+}
+
+EventStreamBody::~EventStreamBody()
+{
+   subscription->Close();
+}
+
+//*****************************************************************************
+//!
+//! \brief Waits for the next event of the subscription.
+//! The first payload sets the reconnection time of the client, so the
+//! response header goes out right away. Webcc asks for the next payload on
+//! a loop thread, which is blocked until an event is published or the
+//! heartbeat is due.
+//!
+//*****************************************************************************
+webcc::Payload EventStreamBody::NextPayload(bool freePrevious)
+{
+   static const int heartbeatInterval = 15000;  // Milliseconds without an event until a heartbeat comment is sent
+   static const HttpServer::SharedBuffer preamble = EventChannel::Chunk("retry: 3000\n\n");
+   static const HttpServer::SharedBuffer heartbeat = EventChannel::Chunk(":\n\n");
+   static const char lastChunk[] = "0\r\n\r\n";
+
+   if (finished)
+      return {};
+
+   if (!started) {
+      started = true;
+      current = { preamble };
+   } else {
+      bool closed = false;
+      current = subscription->Next(heartbeatInterval, closed);
+      if (closed) {
+         finished = true;
+         current.clear();
+         return { boost::asio::buffer(lastChunk, sizeof(lastChunk) - 1) };
+      }
+      if (current.empty())
+         current = { heartbeat };
+   }
+
+   webcc::Payload payload;
+   payload.reserve(current.size());
+   for (const HttpServer::SharedBuffer& event : current)
+      payload.push_back(boost::asio::buffer(event->data(), event->size()));
+   return payload;
+}
+
+void EventStreamBody::Dump(std::ostream& os, std::string_view prefix) const
+{
+   os << prefix << "<event stream>" << std::endl;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#ifndef MAU_HTTPBODYWEBCC__H
+#define MAU_HTTPBODYWEBCC__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#pragma pop_macro("new")
+
+#include <memory>
+#include <vector>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+#ifndef      MAU_EVENTSTREAM__H
+   #include "EventStream.h"
+#endif
+
+#include "webcc/body.h"
+
+//****************************************************************************
+//!
+//! \brief Webcc response body that sends a buffer it shares ownership of.
+//!
+//! The buffer is referenced by the body until the response was written, so
+//! neither a QByteArray nor a HttpServer::SharedBuffer is copied on its way
+//! to the socket.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class BufferBody : public webcc::Body
+{
+public:
+   explicit BufferBody(const QByteArray& buffer);
+   explicit BufferBody(HttpServer::SharedBuffer buffer);
+
+   std::size_t GetSize() const override { return size; }
+   void InitPayload() override { sent = false; }
+   webcc::Payload NextPayload(bool freePrevious = false) override;
+   void Dump(std::ostream& os, std::string_view prefix) const override;
+
+private:
+   QByteArray bytes;                            //!< Owner of the data if constructed from a QByteArray
+   HttpServer::SharedBuffer shared;             //!< Owner of the data if constructed from a shared buffer
+   const char* data;
+   std::size_t size;
+   bool sent = false;
+};
+
+//****************************************************************************
+//!
+//! \brief Reads a sequential device on the thread it lives in.
+//!
+//! Sequential devices, like sockets and processes, are driven by the event
+//! loop of their thread and must not be used from another one. The pump
+//! reads the device on its thread whenever data arrives and keeps it in a
+//! bounded buffer, which a server thread takes the data from. Reading stops
+//! while the buffer is full, so a slow client slows down the device.
+//!
+//****************************************************************************
+
+class DevicePump : public std::enable_shared_from_this<DevicePump>
+{
+public:
+   DevicePump(std::shared_ptr<QIODevice> device, qint64 capacity);
+   ~DevicePump();
+
+   void Start();
+      //!< \brief Starts reading on the thread of the device.
+
+   qint64 Take(char* data, qint64 maxSize, int timeout);
+      //!< \brief Takes data from the buffer, waiting for it if it is empty.
+      //!< \return Bytes taken, 0 at the end of the device, -1 on error or
+      //!<         if no data arrived within #timeout milliseconds.
+
+private:
+   void Fill();
+   void Refill();
+
+   std::shared_ptr<QIODevice> device;
+   QObject* context;                            //!< Receives the signals of the device on its thread
+   qint64 capacity;
+
+   QMutex mutex;
+   QWaitCondition ready;                        //!< Signaled when data was added or the device ended
+   QByteArray buffer;
+   bool pending = false;                        //!< A Fill() is queued on the thread of the device
+   bool channelFinished = false;                //!< The device won't deliver more data than it has available
+   bool ended = false;
+   bool failed = false;
+};
+
+//****************************************************************************
+//!
+//! \brief Webcc response body that is produced while it is sent.
+//!
+//! Only one window of the body is held in memory. The next window is
+//! produced when the previous one was written to the socket, so a slow
+//! client slows down the producer. Without a known content length, the
+//! body is sent with chunked transfer encoding.
+//!
+//! Webcc asks for the next window on an I/O loop thread. A sequential
+//! device is read through a DevicePump on its own thread, the loop thread
+//! only takes the data from the buffer of the pump. While the buffer is
+//! empty, the loop thread and all its connections wait, at most for the
+//! read timeout of the endpoint.
+//!
+//****************************************************************************
+
+class ProducerBody : public webcc::Body
+{
+public:
+   ProducerBody(HttpServer::BodyProducer producer, qint64 contentLength, qint64 window);
+   ProducerBody(std::shared_ptr<QIODevice> device, qint64 contentLength, qint64 window, int readTimeout);
+
+   bool IsChunked() const { return contentLength < 0; }
+
+   std::size_t GetSize() const override { return IsChunked() ? 0 : std::size_t(contentLength); }
+   void InitPayload() override;
+   webcc::Payload NextPayload(bool freePrevious = false) override;
+   void Dump(std::ostream& os, std::string_view prefix) const override;
+
+private:
+   qint64 Produce(char* data, qint64 maxSize);
+
+   HttpServer::BodyProducer producer;
+   std::shared_ptr<QIODevice> device;           //!< Keeps the device open until the body was sent, null if #pump reads it
+   std::shared_ptr<DevicePump> pump;            //!< Reads a sequential device on its thread, null if the device is read directly
+   qint64 contentLength;
+   int readTimeout = 0;                         //!< Milliseconds the loop thread waits for data of a sequential device
+   qint64 produced = 0;
+   bool finished = false;
+
+   QByteArray window;                           //!< Buffer for the current window of the body
+   char chunkHeader[20];                        //!< Size line of the current chunk
+};
+
+//****************************************************************************
+//!
+//! \brief Webcc response body that streams the events of a subscription.
+//!
+//! The body never ends on its own. Every event is a shared buffer that is
+//! already framed as a chunk, so it goes to the socket without a copy. All
+//! events queued since the last write go out with one write. While no event
+//! is published, a comment is sent as heartbeat, which also detects clients
+//! that went away. The body ends when the subscription is closed.
+//! Webcc pulls the payloads on a loop thread and has no asynchronous body,
+//! so every stream blocks a loop thread while it waits for events.
+//!
+//****************************************************************************
+
+class EventStreamBody : public webcc::Body
+{
+public:
+   explicit EventStreamBody(std::shared_ptr<EventSubscription> subscription);
+   ~EventStreamBody() override;
+
+   std::size_t GetSize() const override { return 0; }
+   void InitPayload() override { started = finished = false; }
+   webcc::Payload NextPayload(bool freePrevious = false) override;
+   void Dump(std::ostream& os, std::string_view prefix) const override;
+
+private:
+   std::shared_ptr<EventSubscription> subscription;
+   std::vector<HttpServer::SharedBuffer> current; //!< Events being written, kept alive until the next payload
+   bool started = false;
+   bool finished = false;
+};
+
+}
+
+#endif
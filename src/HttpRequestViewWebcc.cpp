@@ -0,0 +1,274 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "HttpRequestViewWebcc.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QHash>
+#include <QtCore/QFileInfo>
+#pragma pop_macro("new")
+
+#include "webcc/body.h"
+#include "webcc/url.h"
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//! Constructor
+//*****************************************************************************
+HttpRequestViewWebcc::HttpRequestViewWebcc(const webcc::Request& request, const RouteTrie::Match& match, HttpServer::HttpMethod method, const QString& serverName) :
+   request(request),
+   match(match),
+   method(method),
+   serverName(serverName)
+{
+}
+
+std::string_view HttpRequestViewWebcc::Path() const
+{
+   return request.url().path();
+}
+
+std::string_view HttpRequestViewWebcc::QueryString() const
+{
+   return request.url().query();
+}
+
+//*****************************************************************************
+//!
+//! \brief Looks up a query parameter.
+//! Scans the raw query string, so neither the parameters are split up nor
+//! the values are decoded in advance.
+//!
+//*****************************************************************************
+std::string_view HttpRequestViewWebcc::Query(std::string_view name, bool* found) const
+{
+   std::string_view query = QueryString();
+
+   while (!query.empty()) {
+      std::string_view::size_type end = query.find('&');
+      std::string_view parameter = query.substr(0, end);
+      query = end == std::string_view::npos ? std::string_view() : query.substr(end + 1);
+
+      std::string_view::size_type separator = parameter.find('=');
+      if (parameter.substr(0, separator) == name) {
+         if (found)
+            *found = true;
+         return separator == std::string_view::npos ? std::string_view() : parameter.substr(separator + 1);
+      }
+   }
+
+   if (found)
+      *found = false;
+   return std::string_view();
+}
+
+std::string_view HttpRequestViewWebcc::Header(std::string_view name, bool* found) const
+{
+   return request.GetHeader(name, found);
+}
+
+std::string_view HttpRequestViewWebcc::PathVariable(std::string_view name, bool* found) const
+{
+   // Without a route, e.g. for the key of the rate limit, there are no path variables.
+   static const QList<QByteArray> none;
+   const QList<QByteArray>& keys = match.route ? match.route->variableKeys : none;
+   for (qsizetype i = 0; i < keys.size(); i++) {
+      if (std::string_view(keys[i].constData(), keys[i].size()) == name) {
+         if (found)
+            *found = true;
+         return match.variables[i];
+      }
+   }
+
+   if (found)
+      *found = false;
+   return std::string_view();
+}
+
+//*****************************************************************************
+//!
+//! \brief Returns the request body.
+//! A request body that Webcc spooled to a temporary file is memory-mapped on
+//! the first call.
+//!
+//*****************************************************************************
+QByteArrayView HttpRequestViewWebcc::Body() const
+{
+   QString path = BodyFilePath();
+   if (path.isNull()) {
+      const std::string& data = request.data();
+      return QByteArrayView(data.data(), data.size());
+   }
+
+   if (OpenBody() && !mappedBody && bodyFile->size() > 0)
+      mappedBody = bodyFile->map(0, bodyFile->size());
+
+   if (!mappedBody)
+      return QByteArrayView();
+   return QByteArrayView(reinterpret_cast<const char*>(mappedBody), bodyFile->size());
+}
+
+//*****************************************************************************
+//!
+//! \brief Path of the temporary file Webcc spooled the request body to.
+//! \returns QString Path of the file, a null string if the body is in memory.
+//!
+//*****************************************************************************
+QString HttpRequestViewWebcc::BodyFilePath() const
+{
+   std::shared_ptr<webcc::FileBody> fileBody = request.file_body();
+   return fileBody ? QString::fromStdWString(fileBody->path().wstring()) : QString();
+}
+
+//*****************************************************************************
+//!
+//! \brief Opens the temporary file Webcc spooled the request body to.
+//! The file is opened once and kept open for Body().
+//! \returns bool If the body can be read. Always true for a body in memory.
+//!
+//*****************************************************************************
+bool HttpRequestViewWebcc::OpenBody() const
+{
+   QString path = BodyFilePath();
+   if (path.isNull())
+      return true;
+
+   if (!bodyFile) {
+      bodyFile = std::make_unique<QFile>(path);
+      bodyFile->open(QIODevice::ReadOnly);
+   }
+   return bodyFile->isOpen();
+}
+
+//*****************************************************************************
+//! Size of the request body the client announced with Content-Length, -1 if
+//! it didn't announce one.
+//*****************************************************************************
+qint64 HttpRequestViewWebcc::DeclaredBodySize() const
+{
+   bool found = false;
+   std::string_view value = request.GetHeader("Content-Length", &found);
+   if (!found)
+      return -1;
+
+   bool valid = false;
+   qint64 size = QByteArrayView(value.data(), qsizetype(value.size())).trimmed().toLongLong(&valid);
+   return valid ? size : -1;
+}
+
+//*****************************************************************************
+//! Size of the request body in bytes, regardless of where it is stored.
+//*****************************************************************************
+qint64 HttpRequestViewWebcc::BodySize() const
+{
+   QString path = BodyFilePath();
+   return path.isNull() ? qint64(request.data().size()) : QFileInfo(path).size();
+}
+
+//*****************************************************************************
+//!
+//! \brief Builds the URL that was called.
+//! \returns QString The server name followed by path and query.
+//!
+//*****************************************************************************
+QString HttpRequestViewWebcc::Url() const
+{
+   QString url = serverName + QString::fromStdString(request.url().path());
+   if (!request.url().query().empty()) {
+      url += "?" + QString::fromStdString(request.url().query());
+   }
+   return url;
+}
+
+//*****************************************************************************
+//!
+//! \brief Converts the path, path variables and decoded query parameters.
+//! \returns PathInfo Copy of the path information.
+//!
+//*****************************************************************************
+HttpServer::PathInfo HttpRequestViewWebcc::ToPathInfo() const
+{
+   // Determine query component parameters
+   webcc::UrlQuery urlQuery = request.query();
+   QHash<QString, QString> query;
+   for (size_t i = 0; i < urlQuery.Size(); i++) {
+      webcc::UrlQuery::Parameter parameter = urlQuery.Get(i);
+      query.insert(QString::fromStdString(parameter.first), QString::fromStdString(parameter.second));
+   }
+
+   // Determine path variables
+   QHash<QString, QString> pathVariables;
+   for (qsizetype i = 0; i < match.variables.size(); i++) {
+      pathVariables.insert(match.route->variableNames[i], QString::fromUtf8(match.variables[i].data(), match.variables[i].size()));
+   }
+
+   return HttpServer::PathInfo{
+      QString::fromStdString(request.url().path()),
+      pathVariables,
+      QString::fromUtf8(match.multiLevel.data(), match.multiLevel.size()),
+      query
+   };
+}
+
+//*****************************************************************************
+//!
+//! \brief Converts method, headers and body.
+//! \returns HttpRequest Copy of the request.
+//!
+//*****************************************************************************
+HttpServer::HttpRequest HttpRequestViewWebcc::ToRequest() const
+{
+   // Determine headers
+   const webcc::Headers& requestHeaders = request.headers();
+   QHash<QString, QString> headers;
+   for (size_t i = 0; i < requestHeaders.size(); i++) {
+      const webcc::Header& header = requestHeaders.Get(i);
+      headers.insert(QString::fromStdString(header.first), QString::fromStdString(header.second));
+   }
+
+   HttpServer::HttpRequest httpRequest;
+   httpRequest.protocolVersion = Version();
+   httpRequest.method = method;
+   httpRequest.headers = headers;
+
+   QString bodyFilePath = BodyFilePath();
+   if (bodyFilePath.isNull()) {
+      httpRequest.body = QByteArray::fromStdString(request.data());
+   } else {
+      // The server checked with OpenBody() that the file can be read before it called the callback.
+      auto file = std::make_shared<QFile>(bodyFilePath);
+      if (!file->open(QIODevice::ReadOnly))
+         return httpRequest;
+      if (match.route && match.route->options.streamRequestBody)
+         httpRequest.bodyFile = file;
+      else
+         httpRequest.body = file->readAll();  // Spooled, because the path is also routed to a streaming endpoint.
+   }
+
+   return httpRequest;
+}
+
+}
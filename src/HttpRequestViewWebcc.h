@@ -0,0 +1,90 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#ifndef MAU_HTTPREQUESTVIEWWEBCC__H
+#define MAU_HTTPREQUESTVIEWWEBCC__H
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+#ifndef      MAU_ROUTETRIE__H
+   #include "RouteTrie.h"
+#endif
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QFile>
+#pragma pop_macro("new")
+
+#include <memory>
+
+#include "webcc/request.h"
+
+//****************************************************************************
+//!
+//! \brief HttpServer::HttpRequestView of a Webcc request.
+//!
+//! References the Webcc request and the route match. Both have to outlive
+//! the view.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class HttpRequestViewWebcc : public HttpServer::HttpRequestView
+{
+public:
+   HttpRequestViewWebcc(const webcc::Request& request, const RouteTrie::Match& match, HttpServer::HttpMethod method, const QString& serverName);
+
+   HttpServer::ProtocolVersion Version() const override { return HttpServer::HTTP_1_1; }
+   HttpServer::HttpMethod Method() const override { return method; }
+   std::string_view Path() const override;
+   std::string_view QueryString() const override;
+   std::string_view Query(std::string_view name, bool* found = nullptr) const override;
+   std::string_view Header(std::string_view name, bool* found = nullptr) const override;
+   std::string_view PathVariable(std::string_view name, bool* found = nullptr) const override;
+   std::string_view MultiLevel() const override { return match.multiLevel; }
+   QByteArrayView Body() const override;
+
+   QString Url() const override;
+   HttpServer::PathInfo ToPathInfo() const override;
+   HttpServer::HttpRequest ToRequest() const override;
+
+   QString BodyFilePath() const;
+   qint64 BodySize() const;
+   qint64 DeclaredBodySize() const;
+   bool OpenBody() const;
+
+private:
+   const webcc::Request& request;
+   const RouteTrie::Match& match;
+   HttpServer::HttpMethod method;
+   const QString& serverName;
+
+   mutable std::unique_ptr<QFile> bodyFile;     //!< Spooled request body, opened on demand
+   mutable const uchar* mappedBody = nullptr;   //!< Memory-mapped #bodyFile
+};
+
+}
+
+#endif
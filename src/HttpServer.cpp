@@ -21,6 +21,11 @@
 #include "Global.h"
 #include "HttpServer.h"
 
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QDeadlineTimer>
+#pragma pop_macro("new")
+
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
 
@@ -46,6 +51,18 @@ void HttpServer::Port(int port) {
    PortImpl(port);
 }
 
+bool HttpServer::AddListenEndpoint(const HttpServer::ListenEndpoint& endpoint) {
+   return started ? false : AddListenEndpointImpl(endpoint);
+}
+
+bool HttpServer::ClearListenEndpoints() {
+   return started ? false : ClearListenEndpointsImpl();
+}
+
+QList<HttpServer::ListenEndpoint> HttpServer::ListenEndpoints() {
+   return ListenEndpointsImpl();
+}
+
 bool HttpServer::IsHttps() {
    return IsHttpsImpl();
 }
@@ -63,7 +80,15 @@ bool HttpServer::Running() {
 }
 
 bool HttpServer::AddEndpoint(const QString& endpoint, HttpServer::HttpMethod method) {
-   return AddEndpointImpl(endpoint, method);
+   return AddEndpointImpl(endpoint, method, EndpointOptions());
+}
+
+bool HttpServer::AddEndpoint(const QString& endpoint, HttpServer::HttpMethod method, const HttpServer::EndpointOptions& options) {
+   return AddEndpointImpl(endpoint, method, options);
+}
+
+bool HttpServer::AddFileEndpoint(const QString& endpoint, const QString& directory) {
+   return AddFileEndpointImpl(endpoint, directory);
 }
 
 bool HttpServer::RemoveEndpoint(const QString& endpoint, HttpServer::HttpMethod method) {
@@ -78,4 +103,182 @@ bool HttpServer::SetPrivateKey(const QByteArray& keyData, HttpServer::SslEncodin
    return started ? false : SetPrivateKeyImpl(keyData, encoding, algorithm, passphrase);
 }
 
+bool HttpServer::ReloadCertificate(const QByteArray& certificateData, const QByteArray& keyData, HttpServer::SslEncoding encoding, HttpServer::SslKeyAlgorithm algorithm, const QString& passphrase) {
+   return ReloadCertificateImpl(certificateData, keyData, encoding, algorithm, passphrase);
+}
+
+bool HttpServer::TlsSettings(const HttpServer::TlsOptions& options) {
+   return started ? false : TlsSettingsImpl(options);
+}
+
+HttpServer::TlsOptions HttpServer::TlsSettings() {
+   return TlsSettingsImpl();
+}
+
+bool HttpServer::ConnectionSettings(const HttpServer::ConnectionOptions& options) {
+   return started ? false : ConnectionSettingsImpl(options);
+}
+
+HttpServer::ConnectionOptions HttpServer::ConnectionSettings() {
+   return ConnectionSettingsImpl();
+}
+
+bool HttpServer::LoadShedding(const HttpServer::SheddingOptions& options) {
+   return started ? false : LoadSheddingImpl(options);
+}
+
+HttpServer::SheddingOptions HttpServer::LoadShedding() {
+   return LoadSheddingImpl();
+}
+
+bool HttpServer::RateLimit(const HttpServer::RateLimitOptions& options) {
+   return started ? false : RateLimitImpl(options);
+}
+
+HttpServer::RateLimitOptions HttpServer::RateLimit() {
+   return RateLimitImpl();
+}
+
+bool HttpServer::Threads(int workers, int loops) {
+   return started ? false : ThreadsImpl(workers, loops);
+}
+
+int HttpServer::Workers() {
+   return WorkersImpl();
+}
+
+int HttpServer::Loops() {
+   return LoopsImpl();
+}
+
+bool HttpServer::CpuAffinity(const QList<int>& cpus) {
+   return started ? false : CpuAffinityImpl(cpus);
+}
+
+QList<int> HttpServer::CpuAffinity() {
+   return CpuAffinityImpl();
+}
+
+bool HttpServer::StreamingWindow(qint64 bytes) {
+   return started ? false : StreamingWindowImpl(bytes);
+}
+
+qint64 HttpServer::StreamingWindow() {
+   return StreamingWindowImpl();
+}
+
+bool HttpServer::ResponseCacheSize(qint64 bytes) {
+   return ResponseCacheSizeImpl(bytes);
+}
+
+qint64 HttpServer::ResponseCacheSize() {
+   return ResponseCacheSizeImpl();
+}
+
+void HttpServer::InvalidateCache(const QString& endpoint) {
+   InvalidateCacheImpl(endpoint);
+}
+
+void HttpServer::InvalidateCache() {
+   InvalidateCacheImpl(QString());
+}
+
+HttpServer::CompressionStatistics HttpServer::CompressionStats() {
+   return CompressionStatsImpl();
+}
+
+HttpServer::Metrics HttpServer::MetricsSnapshot() {
+   return MetricsSnapshotImpl();
+}
+
+bool HttpServer::AddMetricsEndpoint(const QString& endpoint) {
+   return AddMetricsEndpointImpl(endpoint);
+}
+
+bool HttpServer::AddEventEndpoint(const QString& endpoint, int maxSubscribers) {
+   return started ? false : AddEventEndpointImpl(endpoint, maxSubscribers);
+}
+
+int HttpServer::PublishEvent(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id) {
+   return PublishEventImpl(endpoint, data, event, id);
+}
+
+HttpServer::HttpResponse HttpServer::OnRequest(const QString& endpoint, const HttpRequestView& request) {
+   return OnRequest(endpoint, request.Url(), request.ToPathInfo(), request.ToRequest());
+}
+
+void HttpServer::OnRequestAsync(const QString& endpoint, const HttpRequestView& request, std::shared_ptr<HttpCompletion> completion) {
+   completion->Complete(OnRequest(endpoint, request));
+}
+
+//*****************************************************************************
+//! State of a deferred response, shared by the handle and the waiting server.
+//*****************************************************************************
+struct HttpServer::HttpCompletion::State {
+   enum Result {
+      Pending,
+      Completed,
+      Abandoned
+   };
+
+   QMutex mutex;
+   QWaitCondition completed;
+   Result result = Pending;
+   HttpResponse response;
+};
+
+HttpServer::HttpCompletion::HttpCompletion() :
+   state(std::make_shared<State>())
+{
+}
+
+HttpServer::HttpCompletion::~HttpCompletion() {
+   HttpResponse response;
+   response.statusCode = 500;   // Internal Server Error, the handler dropped the request
+   Complete(std::move(response));
+}
+
+bool HttpServer::HttpCompletion::Complete(HttpResponse response) {
+   QMutexLocker lock(&state->mutex);
+   if (state->result != State::Pending)
+      return false;
+
+   state->response = std::move(response);
+   state->result = State::Completed;
+   state->completed.wakeAll();
+   return true;
+}
+
+void HttpServer::HttpCompletion::Complete(QFuture<HttpResponse> future) {
+   auto fail = [self = shared_from_this()]() {
+      HttpResponse response;
+      response.statusCode = 500;   // Internal Server Error
+      self->Complete(std::move(response));
+   };
+
+   future.then([self = shared_from_this()](HttpResponse response) { self->Complete(std::move(response)); })
+      .onFailed(fail)
+      .onCanceled(fail);
+}
+
+bool HttpServer::HttpCompletion::Wait(std::shared_ptr<HttpCompletion>&& completion, int timeout, HttpResponse& response) {
+   std::shared_ptr<State> state = completion->state;
+   completion.reset();   // If the handler dropped its handle, this completes the request
+
+   QMutexLocker lock(&state->mutex);
+   QDeadlineTimer deadline(timeout);
+   while (state->result == State::Pending) {
+      if (!state->completed.wait(&state->mutex, deadline))
+         break;
+   }
+
+   if (state->result != State::Completed) {
+      state->result = State::Abandoned;
+      return false;
+   }
+
+   response = std::move(state->response);
+   return true;
+}
+
 }
\ No newline at end of file
@@ -32,10 +32,24 @@
 #undef new
 #include <QtCore/QString>
 #include <QtCore/QByteArray>
+#include <QtCore/QByteArrayView>
 #include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QVariantMap>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QFuture>
 #pragma pop_macro("new")
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class QIODevice;
+class QFile;
+
 //****************************************************************************
 //!
 //! \brief Abstract base class for a HTTP server implementation.
@@ -51,7 +65,7 @@ public:
 
    enum ProtocolVersion {
       HTTP_1_1
-      //HTTP_2  // planned feature
+      //HTTP_2  // planned feature, needs a backend with HTTP/2 framing. Webcc speaks HTTP/1.x only, so HTTPS servers negotiate http/1.1 via ALPN.
    };
 
    enum ServerProtocol {
@@ -89,13 +103,171 @@ public:
       HttpMethod method;                           //!< Request method
       QHash<QString, QString> headers;             //!< The headers of the request
       QByteArray body;                             //!< Request body
+      std::shared_ptr<QFile> bodyFile;             //!< Request body of endpoints with EndpointOptions::streamRequestBody, spooled to a temporary file and open for reading. Use QFile::map() to access it memory-mapped. The file is removed after the callback returned.
+   };
+
+   struct EndpointOptions {
+      bool streamRequestBody = false;              //!< Spool the request body to a temporary file while it is received instead of buffering it in memory. The callback is called once the whole body was received, webcc doesn't deliver it incrementally.
+      qint64 maxRequestBodySize = -1;              //!< Maximum size of the request body in bytes, -1 for no limit. Larger requests are answered with 413 Payload Too Large. Webcc receives the whole body before the request is routed, so the limit doesn't bound the memory, disk space or bandwidth an upload uses, it only keeps the body from the callback.
+      bool asynchronous = false;                   //!< Call HttpServer::OnRequestAsync() instead of HttpServer::OnRequest(). Webcc can't resume a response later, so the request still holds a worker thread until it is completed or times out.
+      int asyncTimeout = 30000;                    //!< Milliseconds an asynchronous response may take, at least 1. Late responses are answered with 504 Gateway Timeout.
+      int streamReadTimeout = 100;                 //!< Milliseconds a streamed response waits for data of a sequential HttpResponse::bodyDevice, at least 1. The wait blocks an I/O loop thread and every connection on it, a device that stalls longer cuts the response short.
+      int cacheTtl = 0;                            //!< Milliseconds a 200 response to a GET request is cached per path and query, 0 to disable caching. Cached responses get an ETag header. Requests with an Authorization or Cookie header bypass the cache, responses that set a cookie, are private, no-store or no-cache, or vary by a request header other than Accept-Encoding aren't cached.
+      qint64 compressionThreshold = -1;            //!< Minimum size in bytes of a response body to compress it with a Content-Encoding the client accepts (gzip, deflate), -1 to disable compression
+      int compressionLevel = 6;                    //!< Compression level, from 1 (fastest) to 9 (smallest)
+      int maxConcurrent = 0;                       //!< Requests processed at a time, 0 for no limit, must not be negative. Further requests wait for a slot or are answered with 503 Service Unavailable.
+      int maxQueued = 0;                           //!< Requests waiting for a slot if #maxConcurrent requests are processed, must not be negative. Each holds a worker thread while it waits.
+      int queueTimeout = 1000;                     //!< Milliseconds a request waits for a slot before it is answered with 503 Service Unavailable, must not be negative
+      bool critical = false;                       //!< Never shed when the server is overloaded, see HttpServer::LoadShedding()
+      bool coalesce = false;                       //!< Concurrent GET and HEAD requests with the same path and query share one callback and its response. Requests with an Authorization or Cookie header that isn't in #coalesceHeaders aren't coalesced.
+      QList<QByteArray> coalesceHeaders;           //!< Request headers whose values also have to match to share a response, e.g. Authorization or Accept-Language
+      int coalesceTimeout = 30000;                 //!< Milliseconds a coalesced request waits for the callback of another request, at least 1. Late requests are answered with 504 Gateway Timeout.
+   };
+
+   struct ListenEndpoint {
+      QString address;                             //!< IP address to listen on, IPv4 or IPv6. Webcc listens on every address of the IP version, see ConnectionOptions::exactAddress.
+      int port = 0;                                //!< Port to listen on, 0 to let the system choose a free one
+      QList<int> cpus;                             //!< CPUs the threads of this endpoint are pinned to, empty to use HttpServer::CpuAffinity()
+   };
+
+   struct TlsOptions {
+      int sessionCacheSize = 20480;                //!< Sessions cached by the server for resumption by session ID, 0 to disable the cache
+      int sessionTimeout = 7200;                   //!< Seconds a session can be resumed. The session ticket keys are rotated at the same interval.
+      bool sessionTickets = true;                  //!< Issue session tickets, so clients resume sessions without the cache of the server
+      QString groups = "X25519:P-256:P-384";      //!< ECDHE groups in order of preference, see SSL_CTX_set1_groups_list()
+      QString ciphers;                             //!< TLS 1.2 cipher list in order of preference, see SSL_CTX_set_cipher_list(). Empty for the OpenSSL default.
+      QString cipherSuites;                        //!< TLS 1.3 cipher suites in order of preference, see SSL_CTX_set_ciphersuites(). Empty for the OpenSSL default.
+      bool serverPreference = true;                //!< Choose cipher and group by the preference of the server instead of the client
+   };
+
+   struct TlsStatistics {
+      quint64 fullHandshakes = 0;                  //!< Handshakes that negotiated a new session
+      quint64 resumedHandshakes = 0;               //!< Handshakes that resumed a session, from the cache or a session ticket
+      quint64 ticketKeyRotations = 0;              //!< Number of times the session ticket key was replaced
+
+      double ResumptionRate() const { quint64 all = fullHandshakes + resumedHandshakes; return all ? double(resumedHandshakes) / double(all) : 0.0; }
+         //!< \brief Share of the handshakes that resumed a session.
    };
 
+   struct ConnectionOptions {
+      int maxConnections = 0;                      //!< Open HTTPS connections above which new handshakes are refused, 0 for no limit. The refused socket was accepted already, so this bounds the TLS sessions, not the file descriptors.
+      bool exactAddress = false;                   //!< Fail HttpServer::Start() for a listen address webcc can't bind, instead of listening on every address of its IP version with a warning
+   };
+
+   struct ConnectionStatistics {
+      qint64 open = 0;                             //!< Open HTTPS connections
+      qint64 idle = 0;                             //!< Open HTTPS connections without a request in flight, estimated from HttpServer::Metrics::inFlight
+      quint64 refused = 0;                         //!< HTTPS connections refused because ConnectionOptions::maxConnections were open
+   };
+
+   struct SheddingOptions {
+      double maxCpuLoad = 0;                       //!< CPU time of the process per core, from 0 to 1, above which requests are shed. 0 to ignore the CPU load.
+      int maxLatency = 0;                          //!< Milliseconds the recent requests may take on average, including the wait for a slot, before requests are shed. 0 to ignore the latency.
+      int retryAfter = 1;                          //!< Seconds sent in the Retry-After header of refused requests
+   };
+
+   class HttpRequestView;
+
+   typedef std::function<std::string(const HttpRequestView& request)> RateLimitKeyExtractor;
+      //!< \brief Returns the key of the bucket a request takes its token from.
+
+   struct RateLimitOptions {
+      enum Key {
+         ClientKey,                                //!< Client named by #clientHeader
+         PathKey,                                  //!< URL path of the request
+         CustomKey                                 //!< Returned by #keyExtractor
+      };
+
+      double rate = 0;                             //!< Requests per second per key, 0 to disable the rate limit
+      double burst = 10;                           //!< Requests a key may send at once after being idle, at least 1
+      Key key = ClientKey;                         //!< What the buckets are kept for
+      QByteArray clientHeader;                     //!< Header naming the client, required for ClientKey, e.g. X-Forwarded-For. Webcc doesn't expose the peer address, so the key has to come from a header your trusted reverse proxies write.
+      int trustedProxies = 1;                      //!< Trusted proxies in front of the server, at least 1. Each appends the address it received the request from to #clientHeader, so the client is the entry this many from the end. Entries before it were sent by the client.
+      RateLimitKeyExtractor keyExtractor;          //!< Key of a request for CustomKey. Called before routing, so the request has no path variables.
+   };
+
+   struct SheddingStatistics {
+      double cpuLoad = 0;                          //!< CPU time of the process per core in the last sample, from 0 to 1
+      double latency = 0;                          //!< Average latency of the requests in the last sample in seconds
+      bool overloaded = false;                     //!< If requests are shed
+      quint64 shed = 0;                            //!< Requests refused because the server was overloaded
+   };
+
+   struct CompressionStatistics {
+      quint64 bodies = 0;                          //!< Number of compressed response bodies
+      quint64 bytesIn = 0;                         //!< Bytes before compression
+      quint64 bytesOut = 0;                        //!< Bytes after compression
+      quint64 wallNanoseconds = 0;                 //!< Wall-clock time spent compressing, including time the threads were preempted. Not CPU time.
+
+      double Ratio() const { return bytesOut ? double(bytesIn) / double(bytesOut) : 0.0; }
+         //!< \brief Compression ratio, uncompressed size by compressed size.
+   };
+
+   struct LatencyHistogram {
+      QList<double> bounds;                        //!< Upper bounds of the buckets in seconds
+      QList<quint64> counts;                       //!< Durations per bucket, not cumulative. The last bucket counts the durations above all bounds.
+      quint64 count = 0;                           //!< Number of durations
+      double sum = 0.0;                            //!< Sum of the durations in seconds
+   };
+
+   struct EndpointMetrics {
+      QString endpoint;                            //!< The endpoint as it was registered, empty for requests without a route
+      HttpMethod method = UNKNOWN;                 //!< HTTP request method of the route
+      quint64 requests = 0;                        //!< Finished requests
+      qint64 inFlight = 0;                         //!< Requests being processed
+      quint64 bytesIn = 0;                         //!< Bytes of request bodies
+      quint64 bytesOut = 0;                        //!< Bytes of response bodies, without streamed bodies of unknown size
+      quint64 statusClasses[5] = {};               //!< Responses by status class, 1xx to 5xx
+      quint64 rejected = 0;                        //!< Requests refused by the admission control, see EndpointOptions::maxConcurrent
+      quint64 coalesced = 0;                       //!< Requests answered with the response of another request, see EndpointOptions::coalesce
+      LatencyHistogram routing;                    //!< Time spent looking up the route
+      LatencyHistogram handler;                    //!< Time spent in the callback, or serving the file
+      LatencyHistogram serialization;              //!< Time spent compressing and converting the response
+   };
+
+   struct Metrics {
+      qint64 inFlight = 0;                         //!< Requests being processed
+      QMap<int, quint64> statusCodes;              //!< Responses by status code
+      QList<EndpointMetrics> endpoints;            //!< Metrics per registered endpoint and method
+      EndpointMetrics unmatched;                   //!< Metrics of the requests without a route
+      CompressionStatistics compression;           //!< Counters of the response compression
+      TlsStatistics tls;                           //!< Handshake counters of HTTPS connections
+      ConnectionStatistics connections;            //!< Connection gauges and counters
+      SheddingStatistics shedding;                 //!< Load and shed requests, see HttpServer::LoadShedding()
+      quint64 rateLimited = 0;                     //!< Requests refused with 429 by the rate limit, see HttpServer::RateLimit()
+      quint64 loggedWarnings = 0;                  //!< Warnings logged by the library, see Exception::Log()
+      quint64 loggedErrors = 0;                    //!< Errors logged by the library, see Exception::Log()
+   };
+
+   typedef std::shared_ptr<const std::string> SharedBuffer;
+      //!< \brief Read-only buffer that can be shared between responses.
+
+   typedef std::function<qint64(char* data, qint64 maxSize)> BodyProducer;
+      //!< \brief Produces the next part of a response body while it is sent.
+      //!< Writes at most #maxSize bytes to #data and returns the number of
+      //!< bytes written, 0 at the end of the body or -1 on error. It is
+      //!< called on an I/O loop thread, after the previous part was sent.
+      //!< It must not wait for data, that stalls every connection of the
+      //!< loop. Use HttpResponse::bodyDevice for data that arrives over time.
+
    struct HttpResponse {
       ProtocolVersion protocolVersion = HTTP_1_1;  //!< Protcol version
       int statusCode;                              //!< Response status code
       QHash<QString, QString> headers;             //!< The headers of the response
-      QByteArray body;                             //!< Response body
+      QByteArray body;                             //!< Response body, handed to the server without copying
+      SharedBuffer sharedBody;                     //!< Shared response body, used instead of #body if set
+      BodyProducer bodyProducer;                   //!< Producer of a streamed response body, used instead of #body if set. Called on an I/O loop thread, so it has to return quickly: while it blocks, every connection of that loop stalls.
+      std::shared_ptr<QIODevice> bodyDevice;       //!< Open device a streamed response body is read from, used instead of #body if set. A sequential device is read on its own thread, which needs a running event loop, and released there. An I/O loop thread waits up to EndpointOptions::streamReadTimeout for its data, stalling the other connections of the loop. Other devices are handed over and read on a server thread.
+      qint64 contentLength = -1;                   //!< Size of a streamed body. If -1, chunked transfer encoding is used, unless the device has a size.
+
+      void SetBody(std::string&& data) { sharedBody = std::make_shared<const std::string>(std::move(data)); body.clear(); }
+         //!< \brief Moves #data into the response body without copying it.
+
+      bool IsStreamed() const { return bodyProducer || bodyDevice; }
+         //!< \brief If the response body is produced while it is sent.
+
+      qsizetype BodySize() const { return IsStreamed() ? contentLength : sharedBody ? qsizetype(sharedBody->size()) : body.size(); }
+         //!< \brief Size of the response body in bytes, -1 if a streamed body has no known size.
    };
 
    struct PathInfo {
@@ -105,6 +277,96 @@ public:
       QHash<QString, QString> query;               //!< The query component of the URI
    };
 
+   class HttpRequestView {
+      //!< \brief Read-only view of a received request.
+      //!< All data is referenced from the request of the server implementation,
+      //!< nothing is copied or converted until it is looked up. The view and
+      //!< everything returned from it is only valid during the
+      //!< HttpServer::OnRequest(QString, HttpRequestView) callback.
+   public:
+      virtual ~HttpRequestView() {}
+
+      virtual ProtocolVersion Version() const = 0;
+         //!< \brief Protocol version of the request.
+
+      virtual HttpMethod Method() const = 0;
+         //!< \brief Request method.
+
+      virtual std::string_view Path() const = 0;
+         //!< \brief The URL path.
+
+      virtual std::string_view QueryString() const = 0;
+         //!< \brief The query component of the URI without the leading '?', not decoded.
+
+      virtual std::string_view Query(std::string_view name, bool* found = nullptr) const = 0;
+         //!< \brief Looks up a query parameter.
+         //!< \param name  Name of the parameter, as it appears in the query string.
+         //!< \param found Set to whether the parameter exists, if not null.
+         //!< \return The value of the first parameter with #name, not decoded.
+
+      virtual std::string_view Header(std::string_view name, bool* found = nullptr) const = 0;
+         //!< \brief Looks up a header. Header names are case-insensitive.
+         //!< \param name  Name of the header.
+         //!< \param found Set to whether the header exists, if not null.
+         //!< \return The value of the header.
+
+      virtual std::string_view PathVariable(std::string_view name, bool* found = nullptr) const = 0;
+         //!< \brief Looks up a path variable of the endpoint.
+         //!< \param name  Name of the path variable.
+         //!< \param found Set to whether the path variable exists, if not null.
+         //!< \return The value of the path variable.
+
+      virtual std::string_view MultiLevel() const = 0;
+         //!< \brief Path that matched the multi level '#' wildcard.
+
+      virtual QByteArrayView Body() const = 0;
+         //!< \brief Request body. A spooled request body is memory-mapped.
+
+      virtual QString Url() const = 0;
+         //!< \brief Builds the URL that was called.
+
+      virtual PathInfo ToPathInfo() const = 0;
+         //!< \brief Converts the path, path variables and query into a PathInfo.
+
+      virtual HttpRequest ToRequest() const = 0;
+         //!< \brief Converts the request into a HttpRequest. Copies headers and body.
+   };
+
+   class MAUCPPHTTPSERVER_EXPORT HttpCompletion : public std::enable_shared_from_this<HttpCompletion> {
+      //!< \brief Handle to complete a deferred response.
+      //!< Passed to HttpServer::OnRequestAsync(). The response can be
+      //!< completed once, from any thread. A handle that is released without
+      //!< completing the request completes it with 500 (Internal Server Error).
+      //!< Webcc can't resume a response, so the worker thread of the request
+      //!< waits until it is completed.
+      friend class HttpServerWebcc;
+   public:
+      HttpCompletion();
+      ~HttpCompletion();
+      HttpCompletion(const HttpCompletion&) = delete;
+      HttpCompletion& operator=(const HttpCompletion&) = delete;
+
+      bool Complete(HttpResponse response);
+         //!< \brief Completes the request with #response.
+         //!< \return False if the request was already completed or timed out.
+
+      void Complete(QFuture<HttpResponse> future);
+         //!< \brief Completes the request with the result of #future when it finishes.
+         //!< A canceled or failed future completes it with 500 (Internal Server Error).
+
+   private:
+      static bool Wait(std::shared_ptr<HttpCompletion>&& completion, int timeout, HttpResponse& response);
+         //!< \brief Releases #completion and waits until the request is completed.
+         //!< The calling worker thread is blocked while it waits.
+         //!< \param completion The handle passed to the callback, released by the call.
+         //!< \param timeout    Milliseconds to wait.
+         //!< \param response   Set to the response if it was completed in time.
+         //!< \return If the request was completed in time. Otherwise it can't be completed anymore.
+
+      struct State;
+      std::shared_ptr<State> state;                //!< Shared with the waiting server thread, which doesn't keep the handle alive
+   };
+
    void Protocol(ServerProtocol protocol);
       //!< \brief Set the server protocol.
       //! If the protocol is set to HTTPS the server certificate and private 
@@ -120,6 +382,9 @@ public:
    void Address(const QString& address);
       //!< \brief Sets the address for this server.
       //!< The server address is the IP address under which it is reachable.
+      //!< Webcc listens on every address of its IP version and logs a
+      //!< warning for a specific address, unless ConnectionOptions::exactAddress
+      //!< is set, then HttpServer::Start() fails.
       //!< \param address The IP address.
       //!< \sa HttpServer::Address() to get the address.
 
@@ -135,6 +400,29 @@ public:
       //!< \param port The port number.
       //!< \sa HttpServer::Port() to get the port.
 
+   bool AddListenEndpoint(const ListenEndpoint& endpoint);
+      //!< \brief Adds an address and port the server listens on.
+      //!< The server listens on HttpServer::Address() and HttpServer::Port()
+      //!< and on every added endpoint. Each endpoint gets threads of its own,
+      //!< see HttpServer::Threads(), so it can be pinned to the CPUs near the
+      //!< network interface of its address. All endpoints share the
+      //!< registered endpoints. Every endpoint has an acceptor of its own, so
+      //!< clients spread over several ports are accepted in parallel. Webcc
+      //!< doesn't share a port between acceptors (SO_REUSEPORT).
+      //!< \param endpoint Address, port and CPUs to listen with.
+      //!< \return bool    If the endpoint was added. Not possible while the server is running.
+      //!< \sa HttpServer::ListenEndpoints()
+
+   bool ClearListenEndpoints();
+      //!< \brief Removes all endpoints added with HttpServer::AddListenEndpoint().
+      //!< \return bool If the endpoints were removed. Not possible while the server is running.
+
+   QList<ListenEndpoint> ListenEndpoints();
+      //!< \brief All addresses and ports the server listens on.
+      //!< The first one is HttpServer::Address() and HttpServer::Port(). While
+      //!< the server is running the ports are the actual ones.
+      //!< \return The listen endpoints.
+
    bool IsHttps();
       //!< \brief If this server is a HTTPS server.
       //!< If this server is configured with a server certificate and a private
@@ -143,6 +431,8 @@ public:
 
    bool Start();
       //!< \brief Starts the server.
+      //!< Returns once the server accepts connections. A port of 0 is
+      //!< assigned when the server binds it, see HttpServer::Port().
       //!< \return If the server was started.
       //!< \sa HttpServer::Stop() to stop the server.
 
@@ -167,6 +457,30 @@ public:
       //!<     for the callback.
       //!< \sa HttpServer::RemoveEndpoint(QString, HttpMethod)
 
+   bool AddEndpoint(const QString& endpoint, HttpMethod method, const EndpointOptions& options);
+      //!< \brief Adds an endpoint with options to the server.
+      //!< Endpoints that stream the request body can only be added while the
+      //!< server is stopped, otherwise an exception is raised.
+      //!< \param endpoint Endpoint which should be handled by this server.
+      //!< \param method   HTTP request method that should be routed.
+      //!< \param options  Options of the endpoint.
+      //!< \return bool    If the endpoint was added.
+      //!< \sa HttpServer::AddEndpoint(QString, HttpMethod)
+
+   bool AddFileEndpoint(const QString& endpoint, const QString& directory);
+      //!< \brief Adds an endpoint serving the files of a directory.
+      //!< The path matched by the '#' wildcard at the end of #endpoint selects
+      //!< the file below #directory, e.g. "/ui/#" maps "/ui/js/app.js" to
+      //!< "<directory>/js/app.js". Requests are answered by the server itself
+      //!< without calling HttpServer::OnRequest(). Files are read window by
+      //!< window while they are sent, see HttpServer::StreamingWindow(), with
+      //!< Range, If-None-Match and If-Modified-Since support. Routes for
+      //!< GET and HEAD are added, remove them with HttpServer::RemoveEndpoint().
+      //!< \param endpoint  Endpoint which should be handled by this server.
+      //!< \param directory Directory to serve.
+      //!< \return bool     If the endpoint was added.
+      //!< \sa HttpServer::AddEndpoint(QString, HttpMethod)
+
    bool RemoveEndpoint(const QString& endpoint, HttpMethod method);
       //!< \brief Removes an endpoint from the server.
       //!< \param endpoint Endpoint which should be removed from this server.
@@ -179,6 +493,8 @@ public:
       //!< For SSL/TLS encrypted connections a server SSL certificate and
       //!< private key have to be set. To set the private key, use
       //!< HttpServer::SetPrivateKey(QByteArray, SslKeyAlgorithm, SslEncoding).
+      //!< PEM data may hold intermediate certificates after the server
+      //!< certificate, they are sent to the clients as its chain.
       //!< \param certificateData   The data of the server certificate.
       //!< \param encoding          SSL certificate encoding to use.
       //!< \return Whether the certificate could be set or not.
@@ -198,24 +514,265 @@ public:
       //!< \sa HttpServer::SetCertificate(QByteArray, SslEncoding) for setting
       //!<     the certificate.
 
+   bool ReloadCertificate(const QByteArray& certificateData, const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase);
+      //!< \brief Replaces the server certificate and its private key, also while the server is running.
+      //!< New connections use them from their next handshake on. Established
+      //!< connections and the sessions they resume are kept, so rotating a
+      //!< certificate doesn't need a restart. Nothing is replaced if either
+      //!< is invalid or if the key doesn't belong to the certificate.
+      //!< \param certificateData The data of the server certificate.
+      //!< \param keyData         The data of the private key.
+      //!< \param encoding        Encoding of certificate and private key.
+      //!< \param algorithm       The key algorithm of the private key.
+      //!< \param passphrase      Passphrase for the private key.
+      //!< \return Whether certificate and private key were replaced.
+      //!< \sa HttpServer::SetCertificate(QByteArray, SslEncoding) and
+      //!<     HttpServer::SetPrivateKey(QByteArray, SslEncoding, SslKeyAlgorithm, QString)
+      //!<     to set them before the server is started.
+
+   bool TlsSettings(const TlsOptions& options);
+      //!< \brief Sets the TLS session resumption, groups and ciphers of HTTPS connections.
+      //!< Resuming a session skips the key exchange and the certificate,
+      //!< so reconnecting clients get close to the setup cost of HTTP. The
+      //!< settings can't be changed while the server is running.
+      //!< \param options The TLS settings.
+      //!< \return Whether the settings could be set.
+      //!< \sa HttpServer::TlsSettings() to get the settings and
+      //!<     HttpServer::Metrics::tls for the handshake counters.
+
+   TlsOptions TlsSettings();
+      //!< \brief Retrieves the TLS settings of HTTPS connections.
+      //!< \return The TLS settings.
+      //!< \sa HttpServer::TlsSettings(TlsOptions) to set the settings.
+
+   bool ConnectionSettings(const ConnectionOptions& options);
+      //!< \brief Sets how many connections may be open.
+      //!< Webcc doesn't expose its connections, so they are counted and
+      //!< limited for HTTPS only, where every connection has a TLS handshake.
+      //!< Plain HTTP connections are neither counted nor bounded, put a
+      //!< reverse proxy in front of the server to limit them. Webcc has no
+      //!< timeouts for idle connections, headers or bodies, no limit of
+      //!< requests per connection and no way to pause accepting. The settings
+      //!< can't be changed while the server is running.
+      //!< \param options The connection settings.
+      //!< \return Whether the settings could be set.
+      //!< \sa HttpServer::ConnectionSettings() to get the settings and
+      //!<     HttpServer::Metrics::connections for the gauges.
+
+   ConnectionOptions ConnectionSettings();
+      //!< \brief Retrieves the connection settings.
+      //!< \return The connection settings.
+      //!< \sa HttpServer::ConnectionSettings(ConnectionOptions) to set the settings.
+
+   bool LoadShedding(const SheddingOptions& options);
+      //!< \brief Sets when the server sheds load.
+      //!< While the server is overloaded, requests to callback endpoints that
+      //!< aren't EndpointOptions::critical are answered with 503 (Service
+      //!< Unavailable) before they reach a callback, so critical endpoints
+      //!< keep their latency. The load is sampled every 250 milliseconds. The
+      //!< settings can't be changed while the server is running.
+      //!< \param options The shedding settings.
+      //!< \return Whether the settings could be set.
+      //!< \sa HttpServer::LoadShedding() to get the settings and
+      //!<     HttpServer::Metrics::shedding for the load.
+
+   SheddingOptions LoadShedding();
+      //!< \brief Retrieves the shedding settings.
+      //!< \return The shedding settings.
+      //!< \sa HttpServer::LoadShedding(SheddingOptions) to set the settings.
+
+   bool RateLimit(const RateLimitOptions& options);
+      //!< \brief Sets the rate limit of the requests.
+      //!< Every key has a token bucket. A request without a token is answered
+      //!< with 429 (Too Many Requests) and Retry-After before it is routed,
+      //!< so a flooding client costs little more than reading its request.
+      //!< Requests without a key, e.g. local clients that don't pass the proxy
+      //!< and so have no client header, aren't limited instead of sharing a
+      //!< bucket, and a warning is logged once. Webcc doesn't expose the peer
+      //!< address to fall back to. The settings can't be changed while the
+      //!< server is running.
+      //!< \param options The rate limit settings.
+      //!< \return Whether the settings could be set.
+      //!< \sa HttpServer::RateLimit() to get the settings and
+      //!<     HttpServer::Metrics::rateLimited for the refused requests.
+
+   RateLimitOptions RateLimit();
+      //!< \brief Retrieves the rate limit settings.
+      //!< \return The rate limit settings.
+      //!< \sa HttpServer::RateLimit(RateLimitOptions) to set the settings.
+
+   bool Threads(int workers, int loops);
+      //!< \brief Sets the number of threads the server runs on.
+      //!< Worker threads call HttpServer::OnRequest(), so with more than one
+      //!< worker the callback is called concurrently and has to be thread-safe.
+      //!< Loop threads do the network I/O of the connections.
+      //!< The thread counts can't be changed while the server is running.
+      //!< \param workers Number of threads handling requests. Defaults to 1.
+      //!< \param loops   Number of threads running the I/O loop. Defaults to 1.
+      //!< \return Whether the thread counts could be set.
+      //!< \sa HttpServer::Workers() and HttpServer::Loops()
+
+   int Workers();
+      //!< \brief Retrieves the number of worker threads handling requests.
+      //!< \return Number of worker threads.
+      //!< \sa HttpServer::Threads(int, int) to set the number.
+
+   int Loops();
+      //!< \brief Retrieves the number of threads running the I/O loop.
+      //!< \return Number of I/O loop threads.
+      //!< \sa HttpServer::Threads(int, int) to set the number.
+
+   bool CpuAffinity(const QList<int>& cpus);
+      //!< \brief Pins the threads of the server to a set of CPUs.
+      //!< All worker and I/O loop threads are restricted to the given CPUs.
+      //!< The affinity can't be changed while the server is running.
+      //!< \param cpus Indices of the CPUs to run on. An empty list removes the restriction.
+      //!< \return Whether the affinity could be set.
+      //!< \sa HttpServer::CpuAffinity() to get the CPU set.
+
+   QList<int> CpuAffinity();
+      //!< \brief Retrieves the CPUs the threads of the server are pinned to.
+      //!< \return Indices of the CPUs, empty if the threads aren't pinned.
+      //!< \sa HttpServer::CpuAffinity(QList<int>) to set the CPU set.
+
+   bool StreamingWindow(qint64 bytes);
+      //!< \brief Sets the size of the window streamed response bodies are sent in.
+      //!< A streamed body (HttpResponse::bodyProducer, HttpResponse::bodyDevice)
+      //!< is held in memory one window at a time per response.
+      //!< The window can't be changed while the server is running.
+      //!< \param bytes Size of the window in bytes. Defaults to 64 KiB.
+      //!< \return Whether the window size could be set.
+      //!< \sa HttpServer::StreamingWindow() to get the window size.
+
+   qint64 StreamingWindow();
+      //!< \brief Retrieves the size of the window streamed response bodies are sent in.
+      //!< \return Size of the window in bytes.
+      //!< \sa HttpServer::StreamingWindow(qint64) to set the window size.
+
+   bool ResponseCacheSize(qint64 bytes);
+      //!< \brief Sets the memory the response cache may use.
+      //!< Responses of endpoints with EndpointOptions::cacheTtl are kept until
+      //!< they expire. If the cache is full, the least recently used responses
+      //!< are dropped.
+      //!< \param bytes Size of the cache in bytes. Defaults to 16 MiB, 0 disables the cache.
+      //!< \return Whether the cache size could be set.
+      //!< \sa HttpServer::ResponseCacheSize() to get the cache size.
+
+   qint64 ResponseCacheSize();
+      //!< \brief Retrieves the memory the response cache may use.
+      //!< \return Size of the cache in bytes.
+      //!< \sa HttpServer::ResponseCacheSize(qint64) to set the cache size.
+
+   void InvalidateCache(const QString& endpoint);
+      //!< \brief Drops the cached responses of an endpoint.
+      //!< Call it when the data an endpoint returns has changed, so the next
+      //!< request calls HttpServer::OnRequest() again.
+      //!< \param endpoint The endpoint, as it was registered.
+
+   void InvalidateCache();
+      //!< \brief Drops all cached responses.
+
+   CompressionStatistics CompressionStats();
+      //!< \brief Retrieves the counters of the response compression.
+      //!< Bodies of cached responses are counted once per content coding,
+      //!< because the compressed variants are cached as well.
+      //!< \return Counters since the server was created.
+
+   Metrics MetricsSnapshot();
+      //!< \brief Retrieves the request metrics of the server.
+      //!< Recording the metrics is lock-free. The snapshot sums up the
+      //!< counters of all threads, so it is consistent per counter only.
+      //!< \return Metrics since the server was created. The metrics of a
+      //!<         removed endpoint are dropped with it.
+      //!< \sa HttpServer::AddMetricsEndpoint(QString)
+
+   bool AddMetricsEndpoint(const QString& endpoint = "/metrics");
+      //!< \brief Adds an endpoint returning the metrics in the Prometheus text format.
+      //!< GET requests are answered by the server itself without calling
+      //!< HttpServer::OnRequest().
+      //!< \param endpoint Endpoint which should return the metrics.
+      //!< \return bool    If the endpoint was added.
+      //!< \sa HttpServer::MetricsSnapshot()
+
+   bool AddEventEndpoint(const QString& endpoint, int maxSubscribers = 4);
+      //!< \brief Adds an endpoint streaming Server-Sent Events (text/event-stream).
+      //!< A GET request subscribes to the endpoint and the response stays open
+      //!< until the server is stopped or the endpoint is removed. Events are
+      //!< sent with HttpServer::PublishEvent(). Webcc has no asynchronous
+      //!< response bodies, so every subscriber holds an I/O thread while it
+      //!< waits for events and the server starts #maxSubscribers additional
+      //!< I/O threads per listen endpoint. Subscribers never hold the I/O
+      //!< threads set with HttpServer::Threads(): a subscriber that would
+      //!< leave fewer than HttpServer::Loops() of them to the other
+      //!< connections is refused. The endpoint suits a few clients, e.g.
+      //!< dashboards, not a fan-out to many. All event endpoints together may
+      //!< have at most 256 subscribers. Further subscribers are answered with
+      //!< 503 (Service Unavailable).
+      //!< Event endpoints can't be added while the server is running.
+      //!< \param endpoint       Endpoint to subscribe to, with path variables or wildcards.
+      //!< \param maxSubscribers Maximum number of concurrent subscribers.
+      //!< \return bool          If the endpoint was added.
+
+   int PublishEvent(const QString& endpoint, const QByteArray& data, const QString& event = QString(), const QString& id = QString());
+      //!< \brief Sends an event to all subscribers of an event endpoint.
+      //!< The event is serialized once and shared by all subscribers. A
+      //!< subscriber that falls behind by too many events is disconnected,
+      //!< EventSource clients reconnect on their own. Last-Event-ID isn't
+      //!< evaluated, events published while a client was away are lost.
+      //!< \param endpoint The event endpoint, as it was registered.
+      //!< \param data     Data of the event, every line is sent as a data field.
+      //!< \param event    Type of the event, empty for the default type "message".
+      //!< \param id       ID of the event, empty for none.
+      //!< \return int     Number of subscribers the event was queued for, or -1
+      //!<                 if #endpoint is no event endpoint.
+
 protected:
    virtual void ProtocolImpl(ServerProtocol protocol) = 0;
    virtual QString AddressImpl() = 0;
    virtual void AddressImpl(const QString& address) = 0;
    virtual int PortImpl() = 0;
    virtual void PortImpl(int port) = 0;
+   virtual bool AddListenEndpointImpl(const ListenEndpoint& endpoint) = 0;
+   virtual bool ClearListenEndpointsImpl() = 0;
+   virtual QList<ListenEndpoint> ListenEndpointsImpl() = 0;
 
    virtual bool IsHttpsImpl() = 0;
 
    virtual bool StartImpl() = 0;
    virtual bool StopImpl() = 0;
 
-   virtual bool AddEndpointImpl(const QString& endpoint, HttpMethod method) = 0;
+   virtual bool AddEndpointImpl(const QString& endpoint, HttpMethod method, const EndpointOptions& options) = 0;
+   virtual bool AddFileEndpointImpl(const QString& endpoint, const QString& directory) = 0;
    virtual bool RemoveEndpointImpl(const QString& endpoint, HttpMethod method) = 0;
 
    virtual bool SetCertificateImpl(const QByteArray& certificateData, SslEncoding encoding) = 0;
    virtual bool SetPrivateKeyImpl(const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase) = 0;
 
+   virtual bool ReloadCertificateImpl(const QByteArray& certificateData, const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase) = 0;
+   virtual bool TlsSettingsImpl(const TlsOptions& options) = 0;
+   virtual TlsOptions TlsSettingsImpl() = 0;
+   virtual bool ConnectionSettingsImpl(const ConnectionOptions& options) = 0;
+   virtual ConnectionOptions ConnectionSettingsImpl() = 0;
+   virtual bool LoadSheddingImpl(const SheddingOptions& options) = 0;
+   virtual SheddingOptions LoadSheddingImpl() = 0;
+   virtual bool RateLimitImpl(const RateLimitOptions& options) = 0;
+   virtual RateLimitOptions RateLimitImpl() = 0;
+   virtual bool ThreadsImpl(int workers, int loops) = 0;
+   virtual int WorkersImpl() = 0;
+   virtual int LoopsImpl() = 0;
+   virtual bool CpuAffinityImpl(const QList<int>& cpus) = 0;
+   virtual QList<int> CpuAffinityImpl() = 0;
+   virtual bool StreamingWindowImpl(qint64 bytes) = 0;
+   virtual qint64 StreamingWindowImpl() = 0;
+   virtual bool ResponseCacheSizeImpl(qint64 bytes) = 0;
+   virtual qint64 ResponseCacheSizeImpl() = 0;
+   virtual void InvalidateCacheImpl(const QString& endpoint) = 0;
+   virtual CompressionStatistics CompressionStatsImpl() = 0;
+   virtual Metrics MetricsSnapshotImpl() = 0;
+   virtual bool AddMetricsEndpointImpl(const QString& endpoint) = 0;
+   virtual bool AddEventEndpointImpl(const QString& endpoint, int maxSubscribers) = 0;
+   virtual int PublishEventImpl(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id) = 0;
+
    virtual HttpResponse OnRequest(const QString& endpoint, const QString& url, const PathInfo& pathInfo, const HttpRequest& request) { return HttpResponse();  };
       //!< \brief Called when a new request was received.
       //!< #endpoint contains the registered endpoint (with placeholders) and path
@@ -226,6 +783,31 @@ protected:
       //!< \param request  Request data send by the client.
       //!< \returns        The HTTPResponse containing all data for the server response.
 
+   virtual HttpResponse OnRequest(const QString& endpoint, const HttpRequestView& request);
+      //!< \brief Called when a new request was received, without copying the request.
+      //!< This is the callback the server calls. The default implementation
+      //!< converts the request and calls
+      //!< HttpServer::OnRequest(QString, QString, PathInfo, HttpRequest).
+      //!< Override it for endpoints that should look up only the data they
+      //!< need (add 'using HttpServer::OnRequest;' to keep the other overload visible).
+      //!< \param endpoint Endpoint that was registered.
+      //!< \param request  View of the request data send by the client.
+      //!< \returns        The HTTPResponse containing all data for the server response.
+
+   virtual void OnRequestAsync(const QString& endpoint, const HttpRequestView& request, std::shared_ptr<HttpCompletion> completion);
+      //!< \brief Called when a new request was received on an asynchronous endpoint.
+      //!< The response is passed to #completion later, from any thread.
+      //!< Webcc can't resume a response, so the request holds a worker thread
+      //!< until it is completed, as a synchronous one does. The callback may
+      //!< hand its work to other threads, but it doesn't free the worker.
+      //!< #request is only valid during the callback, so copy the data that
+      //!< is needed to complete the request. The default implementation
+      //!< completes the request with HttpServer::OnRequest(QString, HttpRequestView).
+      //!< \param endpoint   Endpoint that was registered.
+      //!< \param request    View of the request data send by the client.
+      //!< \param completion Handle to complete the request with the response.
+      //!< \sa HttpServer::EndpointOptions::asynchronous
+
 private:
    bool started = false;
 
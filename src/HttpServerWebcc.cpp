@@ -22,21 +22,40 @@
 #include "Exception.h"
 
 #include "HttpServerWebcc.h"
+#include "RouteTrie.h"
+#include "HttpRequestViewWebcc.h"
+#include "HttpBodyWebcc.h"
+#include "ResponseCache.h"
+#include "Compression.h"
+#include "StaticFiles.h"
+#include "Metrics.h"
+#include "TlsContext.h"
+#include "EventStream.h"
+#include "Admission.h"
+#include "RateLimiter.h"
+#include "SingleFlight.h"
 
 #pragma push_macro("new")
 #undef new
 #include <QtCore/QStringList>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QUrl>
-#include <QtCore/QPair>
 #include <QtCore/QVariant>
 #include <QtCore/QRegularExpression>
-#include <QtNetwork/QTcpSocket>
 #include <QtNetwork/QSslCertificate>
 #include <QtNetwork/QSslKey>
 #pragma pop_macro("new")
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
 
 #include "webcc/url.h"
@@ -44,6 +63,14 @@
 #include "webcc/ssl_server.h"
 #include "webcc/response_builder.h"
 
+#if defined(Q_OS_WIN)
+   #include <windows.h>
+   #include <iphlpapi.h>
+#elif defined(Q_OS_LINUX)
+   #include <pthread.h>
+   #include <sched.h>
+#endif
+
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
 
@@ -65,74 +92,145 @@ private:
    // Webcc View that handles all HTTP requests.
    class RootView : public webcc::View {
    public:
-      RootView(HttpServerWebcc::HttpServerWebccPrivate* parent)
-         : webcc::View(), parent(parent) {}
+      RootView(HttpServerWebcc::HttpServerWebccPrivate* parent, const QList<int>& cpus, int streamMethods = UNKNOWN)
+         : webcc::View(), parent(parent), cpus(cpus), streamMethods(streamMethods) {}
       webcc::ResponsePtr Handle(webcc::RequestPtr request) override;
+      bool Stream(const std::string& method) override;
 
    private :
       HttpServerWebcc::HttpServerWebccPrivate* parent;
+      QList<int> cpus;     // CPUs the worker threads of the listener are pinned to
+      int streamMethods;   // Methods whose request body is spooled to a file
    };
 
    // Thread that on which the server tuns.
    class ServerThread : public QThread {
    public:
-       ServerThread(webcc::Server* server) : server(server) {}
+       ServerThread(webcc::Server* server, int workers, int loops, const QList<int>& cpus)
+          : server(server), workers(workers), loops(loops), cpus(cpus) {}
 
    protected:
        virtual void run();
 
    private:
        webcc::Server* server;
+       int workers;
+       int loops;
+       QList<int> cpus;
+   };
+
+   // Webcc server listening on one address and port, with the thread running it.
+   struct Listener {
+      QHostAddress address;
+      int port;
+      std::unique_ptr<webcc::Server> server;
+      std::unique_ptr<ServerThread> thread;
+      std::unique_ptr<boost::asio::ip::tcp::acceptor> reservation;   // Picks the port and keeps it from other acceptors without SO_REUSEADDR until the server listens
    };
 
 public:
    HttpServerWebccPrivate(HttpServerWebcc* parent);
    ~HttpServerWebccPrivate() {}
 
-   bool Start(const QHostAddress& address, int& port, ServerProtocol protocol);
+   bool Start(QList<ListenEndpoint>& endpoints, ServerProtocol protocol);
    bool Stop();
 
-   bool AddEndpoint(const QString& endpoint, HttpMethod method);
+   bool AddEndpoint(const QString& endpoint, HttpMethod method, const EndpointOptions& options);
+   bool AddFileEndpoint(const QString& endpoint, const QString& directory);
+   bool AddMetricsEndpoint(const QString& endpoint);
+   bool AddEventEndpoint(const QString& endpoint, int maxSubscribers);
+   int PublishEvent(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id);
    bool RemoveEndpoint(const QString& endpoint, HttpMethod method);
 
    bool SetCertificate(const QByteArray& data, SslEncoding encoding);
+   QByteArray CertificatePem() const;
    bool SetPrivateKey(const QByteArray& data, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase);
+   bool ReloadCertificate(const QByteArray& certificateData, const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase);
 
    bool IsHttps();
 
-private:
-   struct UrlMatch {
-      bool match = false;
-      int level = 0;  //!< The level of the match. The higher the number, the more path variables were used.
-      QString endpoint;
-      QHash<QString, QString> pathVariables;
-      QString multiLevel;
-   };
+   void Threads(int workers, int loops);
+   int Workers() const { return workers; }
+   int Loops() const { return loops; }
+   void CpuAffinity(const QList<int>& cpus);
+   QList<int> CpuAffinity() const { return cpuAffinity; }
+   void StreamingWindow(qint64 bytes) { streamingWindow = bytes; }
+   qint64 StreamingWindow() const { return streamingWindow; }
+   void ResponseCacheSize(qint64 bytes) { responseCache.MaxSize(bytes); }
+   qint64 ResponseCacheSize() const { return responseCache.MaxSize(); }
+   void InvalidateCache(const QString& endpoint) { responseCache.Invalidate(endpoint); }
+   CompressionStatistics CompressionStats() const { return compression.Statistics(); }
+   void TlsSettings(const TlsOptions& options) { tls.Options(options); }
+   TlsOptions TlsSettings() const { return tls.Options(); }
+   void ConnectionSettings(const ConnectionOptions& options) { connectionOptions = options; tls.MaxConnections(options.maxConnections); }
+   ConnectionOptions ConnectionSettings() const { return connectionOptions; }
+   void LoadShedding(const SheddingOptions& options) { shedder.Options(options); }
+   SheddingOptions LoadShedding() const { return shedder.Options(); }
+   void RateLimit(const RateLimitOptions& options) { rateLimiter.Options(options); missingKeyWarned = false; }
+   RateLimitOptions RateLimit() const { return rateLimiter.Options(); }
+   HttpServer::Metrics MetricsSnapshot() const;
+
+   static bool PinCurrentThread(const QList<int>& cpus);
 
+private:
    QString            SchemeName(ServerProtocol protocol);
-   int                GetFreePort(int port);
-   UrlMatch           Matches(const QString& endpoint, const QString& url);
+   std::unique_ptr<boost::asio::ip::tcp::acceptor> ReservePort(const QHostAddress& address, int& port);
+   static boost::asio::ip::tcp IpProtocol(const QHostAddress& address);
+   void               Listen(const QHostAddress& address, int port, const QList<int>& cpus, ServerProtocol protocol);
+   bool               WaitForListener(const Listener& listener);
+   static bool        IsListening(const Listener& listener);
    webcc::ResponsePtr HandleRequest(webcc::RequestPtr requestData);
-   webcc::ResponsePtr ProcessRequest(const UrlMatch& match, webcc::RequestPtr requestData);
+   void               ValidateEndpoint(const QString& endpoint);
+   webcc::ResponsePtr ServeMetrics();
+   webcc::ResponsePtr ServeEvents(const RouteTrie::Match& match);
+   int                EventSubscribers() const;
+   static const int   maxStreamThreads = 256;   //!< Loop threads all event endpoints together may block per listen endpoint
+   static qint64      BodySize(const webcc::Message& message);
+   webcc::ResponsePtr ServeFile(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData);
+   webcc::ResponsePtr ProcessRequest(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData);
+   void               Compress(HttpResponse& httpResponse, const QByteArray& encoding, const EndpointOptions& options, const std::shared_ptr<const ResponseCache::Entry>& entry, const QByteArray& cacheKey);
+   webcc::ResponsePtr BuildResponse(const QString& endpoint, HttpMethod method, HttpResponse& httpResponse, int readTimeout);
+   webcc::ResponsePtr NotModified(const HttpResponse& cached);
+   webcc::ResponsePtr Admit(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData, EndpointCounters::Clock::time_point start);
+   webcc::ResponsePtr Unavailable(int retryAfter);
+   std::string        RateLimitKey(const webcc::Request& requestData, HttpMethod method);
+   static QByteArray  CoalescingKey(const RouteTrie::Match& match, HttpMethod method, const HttpRequestView& request);
    QString            MapMethod(HttpMethod method);
    HttpMethod         MapMethod(QString method);
 
 private:
-   mutable QMutex processing;
+   mutable QMutex publishing;                   //!< Serializes the writers of #routes and guards #eventChannels.
 
    HttpServerWebcc* parent;
-   webcc::Server* server;
-   std::unique_ptr<ServerThread> serverThread;
-   QHash<QPair<QString, HttpMethod>, QString> endpoints;
+   std::vector<Listener> listeners;             //!< One webcc server per listen endpoint, empty while stopped
+   boost::asio::io_context reservations;        //!< Owns the sockets reserving the ports while starting, never run
+   std::atomic<std::shared_ptr<const RouteTrie>> routes; //!< Immutable snapshot of the registered endpoints, replaced as a whole on every change. Not lock-free, see HandleRequest().
+   QHash<QString, std::shared_ptr<EventChannel>> eventChannels; //!< Subscribers of the event endpoints by endpoint
+   int streamLoops = 0;                         //!< Loop threads started in addition to #loops for the event subscribers, guarded by #publishing
 
    QString serverName;
    QList<QString> reservedHeaders;
    QRegularExpression pathVariableRx;
-   QRegularExpression pathVariableExactRx;
 
    QSslCertificate certificate;
+   QList<QSslCertificate> chain;                //!< Intermediate certificates following #certificate
    QSslKey privateKey;
 
+   int workers = 1;                             //!< Number of threads calling OnRequest()
+   int loops = 1;                               //!< Number of threads running the I/O loop
+   QList<int> cpuAffinity;                      //!< CPUs the server threads are pinned to, empty if not pinned
+   qint64 streamingWindow = 64 * 1024;          //!< Bytes of a streamed response body held in memory at a time
+   ResponseCache responseCache{ 16 * 1024 * 1024 }; //!< Cached responses of endpoints with EndpointOptions::cacheTtl
+   Compression compression;                     //!< Compresses response bodies and counts the work done
+   StaticFiles staticFiles{ 1000, 4096 };       //!< Metadata of the files served by file endpoints, read again after a second
+   ServerCounters serverCounters;               //!< Server wide metrics, the metrics per endpoint are kept by the routes
+   TlsContext tls;                              //!< Session resumption, groups and ciphers of the SSL contexts, and the handshake counters
+   ConnectionOptions connectionOptions;         //!< Limits of the connections
+   LoadShedder shedder;                         //!< Refuses requests to endpoints that aren't critical while the server is overloaded
+   RateLimiter rateLimiter;                     //!< Token buckets of the clients, refusing requests before they are routed
+   SingleFlight flights;                        //!< Callbacks in flight of endpoints with EndpointOptions::coalesce
+   std::atomic<bool> missingKeyWarned{ false }; //!< A request without a rate limit key was logged
+
    static EventMsg msgUnknownEx;
    static EventMsg msgFailedToStartEx;
    static EventMsg msgInvalidEndpointEx;
@@ -140,11 +238,18 @@ private:
    static EventMsg msgInvalidCharacterInEndpointEx;
    static EventMsg msgUnsupportedHttpMethodEx;
    static EventMsg msgAmbiguousEndpointEx;
+   static EventMsg msgInvalidDirectoryEx;
    static EventMsg msgInvalidStatusCodeEx;
    static EventMsg msgReserverHeaderEx;
    static EventMsg msgMissingCertificateEx;
    static EventMsg msgMissingPrivateKeyEx;
    static EventMsg msgHeadWithBodyWarn;
+   static EventMsg msgAddressNotBoundWarn;
+   static EventMsg msgAddressNotBindableEx;
+   static EventMsg msgInvalidSubscriberLimitEx;
+   static EventMsg msgStreamingEndpointWhileRunningEx;
+   static EventMsg msgUnreadableRequestBodyEx;
+   static EventMsg msgMissingRateLimitKeyWarn;
 };
 
 EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgUnknownEx = EventMsg({
@@ -182,6 +287,11 @@ EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgAmbiguousEndpointEx = Event
    { "de-DE", "Mehrdeutiger Endpunkt '%1'. Registrierter Endpunkt '%2' routet bereits zu diesem Endpunkt." }
 });
 
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgInvalidDirectoryEx = EventMsg({
+   { "en-US", "'%1' is not a directory." },
+   { "de-DE", "'%1' ist kein Verzeichnis." }
+});
+
 EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgInvalidStatusCodeEx = EventMsg({
    { "en-US", "HTTP server '%1', Endpoint '%2': Invalid status code '%3'. The HTTP server returned an non-standardize status codes." },
    { "de-DE", "HTTP-Server '%1', Endpunkt '%2': Ungültiger Status-Code '%3'. Der HTTP-Server hat einen nicht standardisierte Status-Codes zurückgegeben." }
@@ -203,23 +313,70 @@ EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgMissingPrivateKeyEx = Event
  });
 
 EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgHeadWithBodyWarn = EventMsg({
-   { "en-US", "HTTP server '%1', Endpoint '%2': The callback for HEAD requests returns a response body. HEAD requests may not have a response body and the returned body will be ignored." },
-   { "de-DE", "HTTP-Server '%1', Endpunkt '%2': Die Callback-Funktion für HEAD-Anfragen gibt einen Antwort-Body zurück. HEAD-Anfrage dürfen keinen Antwort-Body haben und der zurückgegebene Body wird ignoriert." }
+   { "en-US", "HTTP server '%1', Endpoint '%2': The callback for HEAD requests returns a response body. HEAD requests may not have a response body and the returned body will not be sent." },
+   { "de-DE", "HTTP-Server '%1', Endpunkt '%2': Die Callback-Funktion für HEAD-Anfragen gibt einen Antwort-Body zurück. HEAD-Anfrage dürfen keinen Antwort-Body haben und der zurückgegebene Body wird nicht gesendet." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgAddressNotBoundWarn = EventMsg({
+   { "en-US", "HTTP server '%1': Webcc listens on every address of the IP version, not only on '%2'." },
+   { "de-DE", "HTTP-Server '%1': Webcc lauscht auf allen Adressen der IP-Version, nicht nur auf '%2'." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgAddressNotBindableEx = EventMsg({
+   { "en-US", "HTTP server '%1': Webcc can't listen on the address '%2' only. Use 0.0.0.0 or :: to listen on every address of the IP version." },
+   { "de-DE", "HTTP-Server '%1': Webcc kann nicht nur auf der Adresse '%2' lauschen. Mit 0.0.0.0 oder :: wird auf allen Adressen der IP-Version gelauscht." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgInvalidSubscriberLimitEx = EventMsg({
+   { "en-US", "Invalid number of subscribers %1 for event endpoint '%2'. Every subscriber holds an I/O thread, all event endpoints together may have at most %3." },
+   { "de-DE", "Ungültige Anzahl Abonnenten %1 für den Event-Endpunkt '%2'. Jeder Abonnent belegt einen I/O-Thread, alle Event-Endpunkte zusammen dürfen höchstens %3 haben." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgStreamingEndpointWhileRunningEx = EventMsg({
+   { "en-US", "Endpoint '%1' streams the request body. It can't be added while the server is running." },
+   { "de-DE", "Endpunkt '%1' streamt den Request-Body. Er kann nicht hinzugefügt werden, während der Server läuft." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgUnreadableRequestBodyEx = EventMsg({
+   { "en-US", "HTTP server '%1', Endpoint '%2': The spooled request body '%3' can't be read." },
+   { "de-DE", "HTTP-Server '%1', Endpunkt '%2': Der zwischengespeicherte Request-Body '%3' kann nicht gelesen werden." }
+});
+
+EventMsg HttpServerWebcc::HttpServerWebccPrivate::msgMissingRateLimitKeyWarn = EventMsg({
+   { "en-US", "HTTP server '%1': A request has no rate limit key and isn't limited. Check that the reverse proxy sets the client header." },
+   { "de-DE", "HTTP-Server '%1': Eine Anfrage hat keinen Rate-Limit-Schlüssel und wird nicht begrenzt. Prüfen Sie, ob der Reverse-Proxy den Client-Header setzt." }
 });
 
 //*****************************************************************************
 //! Handle implementation of the webcc::View that handles every HTTP request.
 //*****************************************************************************
 webcc::ResponsePtr  HttpServerWebcc::HttpServerWebccPrivate::RootView::Handle(webcc::RequestPtr request) {
+   // Worker threads inherit the affinity of the server thread on Linux, but
+   // not on Windows. Pin them on their first request instead.
+   thread_local bool pinned = false;
+   if (!pinned) {
+      pinned = true;
+      PinCurrentThread(cpus);
+   }
+
    return parent->HandleRequest(request);
 }
 
+//*****************************************************************************
+//! Tells webcc whether to spool the request body to a temporary file.
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::RootView::Stream(const std::string& method) {
+   return parent->MapMethod(QString::fromStdString(method)) & streamMethods;
+}
+
 //*****************************************************************************
 //! Server thread loop implementation.
+//! Webcc spawns the worker and loop threads from this thread.
 //*****************************************************************************
 void HttpServerWebcc::HttpServerWebccPrivate::ServerThread::run()
 {
-   server->Run();
+   PinCurrentThread(cpus);
+   server->Run(workers, loops);
 }
 
 //*****************************************************************************
@@ -227,73 +384,157 @@ void HttpServerWebcc::HttpServerWebccPrivate::ServerThread::run()
 //*****************************************************************************
 HttpServerWebcc::HttpServerWebccPrivate::HttpServerWebccPrivate(HttpServerWebcc* parent) :
    parent(parent),
-   reservedHeaders({ "Server", "Content-Length", "Connection", "Date" }),
+   routes(std::make_shared<const RouteTrie>()),
+   reservedHeaders({ "Server", "Content-Length", "Transfer-Encoding", "Connection", "Date" }),
    pathVariableRx("\\{(.+)\\}", QRegularExpression::InvertedGreedinessOption)
 {
-   pathVariableExactRx = QRegularExpression(QRegularExpression::anchoredPattern(pathVariableRx.pattern()), QRegularExpression::InvertedGreedinessOption);
 }
 
 //*****************************************************************************
 //!
 //! \brief Starts the server.
-//! \param address   The host address of the server.
-//! \param port      Port to listen to. 0 if the port should be auto assigned.
-//!                  Will be set to the actual port.
+//! Every endpoint gets a webcc server and a server thread of its own. They
+//! share the route table, so the endpoints are reachable under all of them.
+//! If one of them can't be started, the ones already started are stopped.
+//! \param endpoints Addresses and ports to listen to. A port of 0 is auto
+//!                  assigned. Will be set to the actual ports.
+//! \param protocol  HTTP or HTTPS.
 //! \returns bool    If the server was started.
 //!
 //*****************************************************************************
-bool HttpServerWebcc::HttpServerWebccPrivate::Start(const QHostAddress& address, int& port, ServerProtocol protocol)
+bool HttpServerWebcc::HttpServerWebccPrivate::Start(QList<ListenEndpoint>& endpoints, ServerProtocol protocol)
+{
+   QHostAddress address(endpoints.first().address);
+   QString host = address.protocol() == QAbstractSocket::IPv6Protocol ? QString("[%1]").arg(address.toString()) : address.toString();
+   serverName = QString("%1://%2:%3").arg(SchemeName(protocol)).arg(host).arg(endpoints.first().port);
+
+   if (protocol == HttpServer::HTTPS) {
+      if (certificate.isNull()) {
+         Ex(MissingCertificate).Arg(serverName).Raise();
+      } else if (privateKey.isNull()) {
+         Ex(MissingPrivateKey).Arg(serverName).Raise();
+      }
+
+      // Converted once for all listeners
+      QString error;
+      if (!tls.Credentials(CertificatePem(), privateKey.toPem(), error))
+         Ex(FailedToStart).Arg(error).Raise();
+   }
+
+   int subscribers = EventSubscribers();
+   {
+      QMutexLocker lock(&publishing);
+      streamLoops = subscribers;
+      for (const std::shared_ptr<EventChannel>& channel : std::as_const(eventChannels))
+         channel->Open();
+   }
+
+   try {
+      for (qsizetype i = 0; i < endpoints.size(); i++) {
+         ListenEndpoint& endpoint = endpoints[i];
+         QHostAddress endpointAddress(endpoint.address);
+         std::unique_ptr<boost::asio::ip::tcp::acceptor> reservation = ReservePort(endpointAddress, endpoint.port);
+         if (i == 0)
+            serverName = QString("%1://%2:%3").arg(SchemeName(protocol)).arg(host).arg(endpoint.port);
+
+         Listen(endpointAddress, endpoint.port, endpoint.cpus.isEmpty() ? cpuAffinity : endpoint.cpus, protocol);
+         listeners.back().reservation = std::move(reservation);
+      }
+
+      // Webcc starts listening on the server threads. Start() returns once every listener accepts connections.
+      for (Listener& listener : listeners) {
+         bool listening = WaitForListener(listener);
+         listener.reservation.reset();
+         if (!listening)
+            Ex(FailedToStart).Arg(QString("Not listening on port %1.").arg(listener.port)).Raise();
+      }
+   }
+   catch (...) {
+      Stop();
+      throw;
+   }
+
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Creates a webcc server for an address and port and starts its thread.
+//! Webcc creates the acceptor from the IP version only, see IpProtocol(), so
+//! a server for a specific address listens on every address of its version.
+//! A warning is logged in this case, or an exception is raised if
+//! ConnectionOptions::exactAddress is set.
+//!
+//! \param   address   The address to listen on. Null for every IPv4 address.
+//! \param   port      The port to listen on.
+//! \param   cpus      CPUs the threads of the server are pinned to.
+//! \param   protocol  HTTP or HTTPS.
+//!
+//*****************************************************************************
+void HttpServerWebcc::HttpServerWebccPrivate::Listen(const QHostAddress& address, int port, const QList<int>& cpus, ServerProtocol protocol)
 {
-   port = GetFreePort(port);
-   serverName = QString("%1://%2:%3").arg(SchemeName(protocol)).arg(address.toString()).arg(port);
+   if (!address.isNull() && address != QHostAddress::Any && address != QHostAddress::AnyIPv4 && address != QHostAddress::AnyIPv6) {
+      if (connectionOptions.exactAddress)
+         Ex(AddressNotBindable).Arg(serverName).Arg(address.toString()).Raise();
+      Warn(AddressNotBound).Arg(serverName).Arg(address.toString()).Log();
+   }
 
+   Listener listener{ address, port };
    switch (protocol)
    {
       case mau::HttpServer::HTTP:
-         server = new webcc::Server(boost::asio::ip::tcp::v4(), port);
+         listener.server = std::make_unique<webcc::Server>(IpProtocol(address), port);
          break;
       case mau::HttpServer::HTTPS:
-         if (certificate.isNull()) {
-            Ex(MissingCertificate).Arg(serverName).Raise();
-         } else if (privateKey.isNull()) {
-            Ex(MissingPrivateKey).Arg(serverName).Raise();
-         }
-
-         server = new webcc::SslServer(boost::asio::ip::tcp::v4(), port); 
+         listener.server = std::make_unique<webcc::SslServer>(IpProtocol(address), port);
 
-         // Setup ssl context
-         QByteArray certificateData = certificate.toPem();
-         QByteArray privateKeyData  = privateKey.toPem();
+         // Setup ssl context with the credentials of the TLS context, see ReloadCertificate()
+         auto& sslContext = static_cast<webcc::SslServer*>(listener.server.get())->ssl_context();
+         sslContext.set_options(boost::asio::ssl::context::default_workarounds);
 
-         auto& sslContext = static_cast<webcc::SslServer*>(server)->ssl_context();
-         sslContext.set_options          (boost::asio::ssl::context::default_workarounds);
-         sslContext.use_certificate_chain(boost::asio::const_buffer(reinterpret_cast<const void*>(certificateData.constData()), certificateData.size()));
-         sslContext.use_private_key      (boost::asio::const_buffer(reinterpret_cast<const void*>(privateKeyData.constData()), privateKeyData.size()), boost::asio::ssl::context::pem);
+         QString error;
+         if (!tls.Configure(sslContext.native_handle(), error))
+            Ex(FailedToStart).Arg(error).Raise();
          break;
    }
 
-   // Route every request to a RootView view.
-   bool routed = server->Route(
-      webcc::UrlRegex("/.*"),             // URL regex
-      std::make_shared<RootView>(this),   // View
-      {                                   // Methods
-         webcc::methods::kGet,
-         webcc::methods::kPost,
-         webcc::methods::kPut,
-         webcc::methods::kDelete,
-         webcc::methods::kPatch,
-         webcc::methods::kHead,
-         webcc::methods::kOptions
-      }
+   const std::vector<std::string> methods = {
+      webcc::methods::kGet,
+      webcc::methods::kPost,
+      webcc::methods::kPut,
+      webcc::methods::kDelete,
+      webcc::methods::kPatch,
+      webcc::methods::kHead,
+      webcc::methods::kOptions
+   };
+
+   // Webcc decides whether to spool a request body to a file before the view handles the request.
+   // Endpoints streaming the request body therefore get views of their own, matched before the root view.
+   QMap<QString, int> streamingPatterns;
+   for (const RouteTrie::Route& route : routes.load(std::memory_order_acquire)->Routes()) {
+      if (route.options.streamRequestBody)
+         streamingPatterns[RouteTrie::Pattern(route.endpoint)] |= route.method;
+   }
+   for (auto it = streamingPatterns.constBegin(); it != streamingPatterns.constEnd(); it++) {
+      if (!listener.server->Route(webcc::UrlRegex(it.key().toStdString()), std::make_shared<RootView>(this, cpus, it.value()), methods))
+         Ex(FailedToStart).Arg("Routing failed.").Raise();
+   }
+
+   // Route every other request to a RootView view.
+   bool routed = listener.server->Route(
+      webcc::UrlRegex("/.*"),                   // URL regex
+      std::make_shared<RootView>(this, cpus),   // View
+      methods                                   // Methods
    );
 
    if (!routed)
       Ex(FailedToStart).Arg("Routing failed.").Raise();
 
    // Create and start server thread. Necessary because server->run() is blocking.
-   serverThread = std::make_unique<ServerThread>(server);
-   serverThread->start();
-   return true;
+   // Every event subscriber blocks a loop thread while it waits, see EventStreamBody.
+   listener.thread = std::make_unique<ServerThread>(listener.server.get(), workers, loops + streamLoops, cpus);
+   listener.thread->start();
+   listeners.push_back(std::move(listener));
 }
 
 //*****************************************************************************
@@ -304,9 +545,18 @@ bool HttpServerWebcc::HttpServerWebccPrivate::Start(const QHostAddress& address,
 //*****************************************************************************
 bool HttpServerWebcc::HttpServerWebccPrivate::Stop()
 {
-   server->Stop();
-   serverThread->wait();
-   delete server;
+   // Event streams never end on their own. Ending them releases the loop threads writing them.
+   {
+      QMutexLocker lock(&publishing);
+      for (const std::shared_ptr<EventChannel>& channel : std::as_const(eventChannels))
+         channel->Close();
+   }
+
+   for (Listener& listener : listeners)
+      listener.server->Stop();
+   for (Listener& listener : listeners)
+      listener.thread->wait();
+   listeners.clear();
 
    return true;
 }
@@ -320,13 +570,46 @@ bool HttpServerWebcc::HttpServerWebccPrivate::Stop()
 //! multi level wildcard (#) at the end.
 //! Checks if any endpoint is invalid or if an already registered endpoint
 //! routes to #endpoint already.
+//! The route table is never modified in place. A modified copy is published
+//! instead, so requests in flight keep routing on the snapshot they loaded.
+//! Endpoints streaming the request body need a webcc route of their own,
+//! see Start(), so they can't be added while the server is running. An
+//! exception is raised in that case.
 //!
 //! \param   endpoint   Endpoint to add.
 //! \param   method     HTTP request method for the endpoint.
+//! \param   options    Options of the endpoint.
 //! \returns bool       If the endpoint could be added or not.
 //!
 //*****************************************************************************
-bool HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint(const QString& endpoint, HttpServer::HttpMethod method)
+bool HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint(const QString& endpoint, HttpServer::HttpMethod method, const EndpointOptions& options)
+{
+   if (options.streamRequestBody && !listeners.empty())
+      Ex(StreamingEndpointWhileRunning).Arg(endpoint).Raise();
+
+   ValidateEndpoint(endpoint);
+
+   QMutexLocker lock(&publishing);
+   auto next = std::make_shared<RouteTrie>(*routes.load(std::memory_order_acquire));
+
+   // Endpoints with the same path shape and method are ambiguous, regardless of the variable names.
+   QString registeredEndpoint = next->Insert(endpoint, method, options);
+   if (!registeredEndpoint.isNull())
+      Ex(AmbiguousEndpoint).Arg(endpoint).Arg(registeredEndpoint).Raise();
+
+   routes.store(std::move(next), std::memory_order_release);
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Checks if an endpoint is valid.
+//! Raises an exception if it isn't.
+//!
+//! \param   endpoint   Endpoint to check.
+//!
+//*****************************************************************************
+void HttpServerWebcc::HttpServerWebccPrivate::ValidateEndpoint(const QString& endpoint)
 {
    // Check if '#' is a the end of the endpoint
    if (endpoint.contains("#") && endpoint.indexOf("#") != endpoint.length() - 1)   // indexOf returns first occurence
@@ -356,19 +639,176 @@ bool HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint(const QString& endpoin
    //QHttpServerRequest::Method httpMethod = MapMethod(method);
    //if (httpMethod == QHttpServerRequest::Method::Unknown)
    //   Ex(UnsupportedHttpMethod).Raise();
+}
+
+//*****************************************************************************
+//!
+//! \brief Adds an endpoint serving the files of a directory.
+//! The part of the request path matched by the '#' wildcard of #endpoint
+//! selects the file below #directory. Requests are answered by ServeFile()
+//! without calling OnRequest(). Routes for GET and HEAD are added.
+//!
+//! \param   endpoint   Endpoint to add.
+//! \param   directory  Directory to serve.
+//! \returns bool       If the endpoint could be added or not.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::AddFileEndpoint(const QString& endpoint, const QString& directory)
+{
+   ValidateEndpoint(endpoint);
+
+   QFileInfo directoryInfo(directory);
+   if (!directoryInfo.isDir())
+      Ex(InvalidDirectory).Arg(directory).Raise();
+
+   QMutexLocker lock(&publishing);
+   auto next = std::make_shared<RouteTrie>(*routes.load(std::memory_order_acquire));
+
+   for (HttpMethod method : { GET, HEAD }) {
+      QString registeredEndpoint = next->Insert(endpoint, method, EndpointOptions(), RouteTrie::Route::FileRoute, directoryInfo.canonicalFilePath());
+      if (!registeredEndpoint.isNull())
+         Ex(AmbiguousEndpoint).Arg(endpoint).Arg(registeredEndpoint).Raise();
+   }
+
+   routes.store(std::move(next), std::memory_order_release);
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Adds an endpoint returning the metrics of the server.
+//! GET requests are answered by ServeMetrics() without calling OnRequest().
+//!
+//! \param   endpoint   Endpoint to add.
+//! \returns bool       If the endpoint could be added or not.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::AddMetricsEndpoint(const QString& endpoint)
+{
+   ValidateEndpoint(endpoint);
+
+   QMutexLocker lock(&publishing);
+   auto next = std::make_shared<RouteTrie>(*routes.load(std::memory_order_acquire));
+
+   QString registeredEndpoint = next->Insert(endpoint, GET, EndpointOptions(), RouteTrie::Route::MetricsRoute);
+   if (!registeredEndpoint.isNull())
+      Ex(AmbiguousEndpoint).Arg(endpoint).Arg(registeredEndpoint).Raise();
+
+   routes.store(std::move(next), std::memory_order_release);
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Adds an endpoint streaming Server-Sent Events.
+//! GET requests are answered by ServeEvents() without calling OnRequest().
+//! The loop threads the subscribers block are started with the server, so
+//! the endpoint can't be added while it is running.
+//!
+//! \param   endpoint        Endpoint to add.
+//! \param   maxSubscribers  Maximum number of concurrent subscribers.
+//! \returns bool            If the endpoint could be added or not.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::AddEventEndpoint(const QString& endpoint, int maxSubscribers)
+{
+   if (!listeners.empty())
+      return false;
 
-   QPair<QString, HttpMethod> key(endpointAdjusted, method);
-   if (endpoints.contains(key))
-      Ex(AmbiguousEndpoint).Arg(endpoint).Arg(endpoints[key]).Raise();
+   ValidateEndpoint(endpoint);
+   if (maxSubscribers < 1 || EventSubscribers() + maxSubscribers > maxStreamThreads)
+      Ex(InvalidSubscriberLimit).Arg(maxSubscribers).Arg(endpoint).Arg(maxStreamThreads).Raise();
 
-   endpoints.insert(key, endpoint);
+   QMutexLocker lock(&publishing);
+   auto next = std::make_shared<RouteTrie>(*routes.load(std::memory_order_acquire));
+
+   QString registeredEndpoint = next->Insert(endpoint, GET, EndpointOptions(), RouteTrie::Route::EventRoute);
+   if (!registeredEndpoint.isNull())
+      Ex(AmbiguousEndpoint).Arg(endpoint).Arg(registeredEndpoint).Raise();
+
+   eventChannels.insert(endpoint, std::make_shared<EventChannel>(maxSubscribers));
+   routes.store(std::move(next), std::memory_order_release);
    return true;
 }
 
+//*****************************************************************************
+//!
+//! \brief Sends an event to the subscribers of an event endpoint.
+//! The event is serialized once. The subscribers share the buffer, it is
+//! released when the last of them has written it.
+//!
+//! \param   endpoint  The event endpoint, as it was registered.
+//! \param   data      Data of the event.
+//! \param   event     Type of the event, empty for none.
+//! \param   id        ID of the event, empty for none.
+//! \returns int       Number of subscribers reached, -1 if #endpoint is no event endpoint.
+//!
+//*****************************************************************************
+int HttpServerWebcc::HttpServerWebccPrivate::PublishEvent(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id)
+{
+   std::shared_ptr<EventChannel> channel;
+   {
+      QMutexLocker lock(&publishing);
+      channel = eventChannels.value(endpoint);
+   }
+   if (!channel)
+      return -1;
+
+   return channel->Publish(EventChannel::Serialize(data, event, id));
+}
+
+//*****************************************************************************
+//! Number of loop threads the subscribers of all event endpoints may block.
+//! It's added to the loop threads of every listen endpoint and limited to
+//! maxStreamThreads.
+//*****************************************************************************
+int HttpServerWebcc::HttpServerWebccPrivate::EventSubscribers() const
+{
+   QMutexLocker lock(&publishing);
+   int subscribers = 0;
+   for (const std::shared_ptr<EventChannel>& channel : eventChannels)
+      subscribers += channel->MaxSubscribers();
+   return subscribers;
+}
+
+//*****************************************************************************
+//!
+//! \brief Collects the metrics of the server.
+//! The counters of the routes live in the route table snapshot, so the
+//! metrics of a removed endpoint are dropped with it.
+//!
+//! \returns Metrics    The metrics.
+//!
+//*****************************************************************************
+HttpServer::Metrics HttpServerWebcc::HttpServerWebccPrivate::MetricsSnapshot() const
+{
+   HttpServer::Metrics metrics;
+   serverCounters.Collect(metrics);
+
+   for (const RouteTrie::Route& route : routes.load(std::memory_order_acquire)->Routes()) {
+      HttpServer::EndpointMetrics endpoint;
+      endpoint.endpoint = route.endpoint;
+      endpoint.method = route.method;
+      route.counters->Collect(endpoint);
+      metrics.endpoints.append(endpoint);
+   }
+
+   metrics.compression = compression.Statistics();
+   metrics.tls = tls.Statistics();
+   metrics.connections = tls.Connections();
+   metrics.connections.idle = qMax<qint64>(0, metrics.connections.open - metrics.inFlight);
+   shedder.Collect(metrics);
+   metrics.rateLimited = rateLimiter.Rejected();
+   metrics.loggedWarnings = Exception::Logged(Exception::warning);
+   metrics.loggedErrors = Exception::Logged(Exception::error);
+   return metrics;
+}
+
 //*****************************************************************************
 //!
 //! \brief Removes an endpoint from the server.
-//! The endpoint can no longer be reached after it was removed.
+//! The endpoint can no longer be reached after it was removed. Its cached
+//! responses are dropped.
 //!
 //! \param   endpoint   Endpoint to remove.
 //! \param   method     HTTP request method for the endpoint.
@@ -377,22 +817,28 @@ bool HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint(const QString& endpoin
 //*****************************************************************************
 bool HttpServerWebcc::HttpServerWebccPrivate::RemoveEndpoint(const QString& endpoint, HttpServer::HttpMethod method)
 {
-   bool endpointFound = false;
+   QMutexLocker lock(&publishing);
+   auto next = std::make_shared<RouteTrie>(*routes.load(std::memory_order_acquire));
 
-   for (auto it = endpoints.constBegin(); it != endpoints.constEnd(); it++) {
-      if (it.value() == endpoint && it.key().second == method) {
-         endpoints.remove(it.key());
-         endpointFound = true;
-         break;
-      }
-   }
+   if (!next->Remove(endpoint, method))
+      return false;
+
+   routes.store(std::move(next), std::memory_order_release);
+   responseCache.Invalidate(endpoint);
 
-   return endpointFound;
+   if (method == GET) {
+      std::shared_ptr<EventChannel> channel = eventChannels.take(endpoint);
+      if (channel)
+         channel->Close();
+   }
+   return true;
 }
 
 //*****************************************************************************
 //!
 //! \brief Sets the server certificate.
+//! PEM data may hold intermediate certificates after the server certificate,
+//! they are sent to the clients as its chain.
 //!
 //! \param   data Server certificate.
 //! \returns bool If the certificate was set or not.
@@ -407,11 +853,53 @@ bool HttpServerWebcc::HttpServerWebccPrivate::SetCertificate(const QByteArray& d
       default: return false;
    }
 
-   certificate = QSslCertificate(data, qEncoding);
+   chain = QSslCertificate::fromData(data, qEncoding);
+   certificate = chain.isEmpty() ? QSslCertificate() : chain.takeFirst();
 
    return !certificate.isNull();
 }
 
+//*****************************************************************************
+//! The server certificate followed by its chain, as the TLS context reads it.
+//*****************************************************************************
+QByteArray HttpServerWebcc::HttpServerWebccPrivate::CertificatePem() const
+{
+   QByteArray pem = certificate.toPem();
+   for (const QSslCertificate& intermediate : chain)
+      pem += intermediate.toPem();
+   return pem;
+}
+
+//*****************************************************************************
+//!
+//! \brief Replaces the server certificate and its private key.
+//! While the server is running, new connections use them from their next
+//! handshake on and established connections are kept. Nothing is replaced
+//! if either is invalid or if the key doesn't belong to the certificate.
+//!
+//! \param   certificateData  Server certificate.
+//! \param   keyData          Private key.
+//! \returns bool             If certificate and key were replaced.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::ReloadCertificate(const QByteArray& certificateData, const QByteArray& keyData, HttpServer::SslEncoding encoding, HttpServer::SslKeyAlgorithm algorithm, const QString& passphrase)
+{
+   QSslCertificate previousCertificate = certificate;
+   QList<QSslCertificate> previousChain = chain;
+   QSslKey previousKey = privateKey;
+
+   QString error;
+   bool reloaded = SetCertificate(certificateData, encoding)
+      && SetPrivateKey(keyData, encoding, algorithm, passphrase)
+      && tls.Credentials(CertificatePem(), privateKey.toPem(), error);
+   if (!reloaded) {
+      certificate = previousCertificate;
+      chain = previousChain;
+      privateKey = previousKey;
+   }
+   return reloaded;
+}
+
 //*****************************************************************************
 //!
 //! \brief Sets the private key of the server certificate.
@@ -461,6 +949,63 @@ bool HttpServerWebcc::HttpServerWebccPrivate::IsHttps()
    return !certificate.isNull() || !privateKey.isNull();
 }
 
+//*****************************************************************************
+//!
+//! \brief Sets the number of threads the server runs on.
+//! Takes effect on the next start of the server.
+//!
+//! \param workers Number of threads handling requests.
+//! \param loops   Number of threads running the I/O loop.
+//!
+//*****************************************************************************
+void HttpServerWebcc::HttpServerWebccPrivate::Threads(int workers, int loops)
+{
+   HttpServerWebccPrivate::workers = workers;
+   HttpServerWebccPrivate::loops = loops;
+}
+
+//*****************************************************************************
+//!
+//! \brief Sets the CPUs the server threads are pinned to.
+//! Takes effect on the next start of the server.
+//!
+//! \param cpus Indices of the CPUs, empty to remove the restriction.
+//!
+//*****************************************************************************
+void HttpServerWebcc::HttpServerWebccPrivate::CpuAffinity(const QList<int>& cpus)
+{
+   cpuAffinity = cpus;
+}
+
+//*****************************************************************************
+//!
+//! \brief Pins the calling thread to a set of CPUs.
+//!
+//! \param   cpus  Indices of the CPUs. Nothing is done if empty.
+//! \returns bool  If the affinity was set.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::PinCurrentThread(const QList<int>& cpus)
+{
+   if (cpus.isEmpty())
+      return false;
+
+#if defined(Q_OS_WIN)
+   DWORD_PTR mask = 0;
+   for (int cpu : cpus)
+      mask |= DWORD_PTR(1) << cpu;
+   return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(Q_OS_LINUX)
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for (int cpu : cpus)
+      CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+   return false;
+#endif
+}
+
 //*****************************************************************************
 //!
 //! \briefReturns the URI scheme for the given server protocol
@@ -481,76 +1026,164 @@ QString HttpServerWebcc::HttpServerWebccPrivate::SchemeName(ServerProtocol proto
 
 //*****************************************************************************
 //!
-//! \brief Determines a free TCP port.
+//! \brief Picks the TCP port for the webcc acceptor.
+//! Webcc doesn't expose the port its acceptor is bound to, so a port of 0 is
+//! resolved here. The returned socket is bound to the port, but doesn't
+//! listen. Both it and the webcc acceptor set SO_REUSEADDR, so webcc can bind
+//! the port while the socket holds it. This is no reservation: a socket of
+//! another process that sets SO_REUSEADDR as well may bind the port in
+//! between, and on Windows SO_REUSEADDR even lets it take over a listening
+//! port. Webcc then fails to listen and Start() fails. Keep the socket until
+//! the server listens.
 //!
-//! \param   port    Preferred port. Set to 0 if a random port should be returned.
-//! \returns int     A free port.
+//! \param   address Address the server listens on, see IpProtocol().
+//! \param   port    Port to reserve, 0 for any free port. Set to the reserved port.
+//! \returns The reserving socket.
 //!
 //*****************************************************************************
-int HttpServerWebcc::HttpServerWebccPrivate::GetFreePort(int port) {
-   QTcpSocket socket;
-   if (!socket.bind(port, QAbstractSocket::DontShareAddress))
-      Ex(FailedToStart).Arg(socket.errorString()).Raise();
-
-   quint16 assignedPort = socket.localPort();
-   socket.close();
-
-   return assignedPort;
+std::unique_ptr<boost::asio::ip::tcp::acceptor> HttpServerWebcc::HttpServerWebccPrivate::ReservePort(const QHostAddress& address, int& port)
+{
+   boost::asio::ip::tcp::endpoint endpoint(IpProtocol(address), quint16(port));
+   auto reservation = std::make_unique<boost::asio::ip::tcp::acceptor>(reservations);
+
+   boost::system::error_code error;
+   reservation->open(endpoint.protocol(), error);
+   if (!error)
+      reservation->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), error);
+   if (!error)
+      reservation->bind(endpoint, error);
+   if (!error)
+      port = reservation->local_endpoint(error).port();
+   if (error)
+      Ex(FailedToStart).Arg(QString::fromStdString(error.message())).Raise();
+
+   return reservation;
 }
 
 //*****************************************************************************
 //!
-//! \brief Checks if the #endpoint matches the #url.
-//! #endpoint could contain wildcards and path variables and has to be matched
-//! against the url path.
+//! \brief Waits until a webcc server accepts connections.
+//! Webcc has no notification when its acceptor listens. Instead of probing
+//! the port with connections, which clients of the server would see in the
+//! metrics and as failed TLS handshakes, the listening sockets of the system
+//! are looked up, see IsListening(). The lookup backs off from 1 to 50 ms.
 //!
-//! \param   endpoint   Endpoint to check.
-//! \param   url        The URL that was called.
-//! \returns UrlMatch   Struct containing information about the match.
+//! \param   listener  The listener to wait for.
+//! \returns bool      If the server listens. False if its thread ended or
+//!                    the server doesn't listen after 5 seconds.
 //!
 //*****************************************************************************
-HttpServerWebcc::HttpServerWebccPrivate::UrlMatch HttpServerWebcc::HttpServerWebccPrivate::Matches(const QString& endpoint, const QString& url)
+bool HttpServerWebcc::HttpServerWebccPrivate::WaitForListener(const Listener& listener)
 {
-   UrlMatch match;
-   match.endpoint = endpoint;
-
-   // Escape the endpoint, because the URL will be escaped as well.
-   QUrl endpointUrl;
-   endpointUrl.setPath(endpoint);
-   QString escapedEndpoint = endpointUrl.path();
-
-   QStringList urlLevels = url.split("/");
-   QStringList endpointLevels = escapedEndpoint.split("/");
+   static const int timeout = 5000;   // Milliseconds webcc may take to listen
+   static const int maxInterval = 50; // Milliseconds between two lookups at most
+
+   QDeadlineTimer deadline(timeout);
+   for (int interval = 1;; interval = qMin(interval * 2, maxInterval)) {
+      if (IsListening(listener))
+         return true;
+      if (listener.thread->isFinished() || deadline.hasExpired())
+         return false;
+      QThread::msleep(interval);
+   }
+}
 
-   if (urlLevels.length() < endpointLevels.length()) {
-      return match;
-   } else if (urlLevels.length() > endpointLevels.length()) {
-      if (!escapedEndpoint.endsWith("#"))
-         return match;
+//*****************************************************************************
+//!
+//! \brief Checks if a socket of the system listens on the port of a listener.
+//! Reads the TCP table of the IP version of the listener, /proc/net/tcp on
+//! Linux and the listeners of this process on Windows. Other systems have no
+//! such table, the listener is assumed to listen once its thread runs.
+//!
+//! \param   listener  The listener.
+//! \returns bool      If a socket listens on the port.
+//!
+//*****************************************************************************
+bool HttpServerWebcc::HttpServerWebccPrivate::IsListening(const Listener& listener)
+{
+   bool ipv6 = IpProtocol(listener.address) == boost::asio::ip::tcp::v6();
+
+#if defined(Q_OS_WIN)
+   ULONG family = ipv6 ? AF_INET6 : AF_INET;
+   DWORD size = 0;
+   std::vector<char> table;
+   DWORD result = ERROR_INSUFFICIENT_BUFFER;
+   while (result == ERROR_INSUFFICIENT_BUFFER) {
+      table.resize(size);
+      result = GetExtendedTcpTable(table.empty() ? nullptr : table.data(), &size, FALSE, family, TCP_TABLE_OWNER_PID_LISTENER, 0);
    }
+   if (result != NO_ERROR)
+      return false;
 
-   for (int i = 0; i < endpointLevels.length(); i++) {
-      QRegularExpressionMatch pathVariableMatch = pathVariableExactRx.match(endpointLevels[i]);
-      if (pathVariableMatch.hasMatch()) {    // Path variable in endpoint string
-         match.pathVariables.insert(pathVariableMatch.captured(1), urlLevels[i]);
-         match.level++;
-      } else if (endpointLevels[i] == "#") { // '#' should be at the end (checked in AddEndpoint()).
-         match.multiLevel = "/" + urlLevels.mid(i).join("/");  // Add leading '/'
-         match.level = urlLevels.length() - i + 1;             // Should be one higher than the level a path covered by '#' would have, if it had a path variable per level
-      } else if (urlLevels[i] != endpointLevels[i]) {
-         return match;
+   auto matches = [&](const auto& rows) {
+      for (DWORD i = 0; i < rows.dwNumEntries; i++) {
+         if (rows.table[i].dwOwningPid == GetCurrentProcessId() && ntohs(u_short(rows.table[i].dwLocalPort)) == listener.port)
+            return true;
       }
+      return false;
+   };
+   return ipv6 ? matches(*reinterpret_cast<const MIB_TCP6TABLE_OWNER_PID*>(table.data()))
+               : matches(*reinterpret_cast<const MIB_TCPTABLE_OWNER_PID*>(table.data()));
+#elif defined(Q_OS_LINUX)
+   static const QByteArray listenState("0A");   // TCP_LISTEN
+
+   // Procfs files have no size, so they are read in one go. Lines are "sl local_address rem_address st ...", the
+   // local address is "<hex address>:<hex port>".
+   QFile table(ipv6 ? "/proc/net/tcp6" : "/proc/net/tcp");
+   if (!table.open(QIODevice::ReadOnly))
+      return false;
+
+   const QList<QByteArray> lines = table.readAll().split('\n');
+   for (qsizetype i = 1; i < lines.size(); i++) {
+      QList<QByteArray> fields = lines[i].simplified().split(' ');
+      if (fields.size() < 4 || fields[3] != listenState)
+         continue;
+
+      const QByteArray& local = fields[1];
+      bool valid = false;
+      int port = local.mid(local.lastIndexOf(':') + 1).toInt(&valid, 16);
+      if (valid && port == listener.port)
+         return true;
    }
+   return false;
+#else
+   Q_UNUSED(ipv6);
+   return listener.thread->isRunning();
+#endif
+}
 
-   match.match = true;
-   return match;
+//*****************************************************************************
+//!
+//! \brief Maps an address to the IP version of the webcc acceptor.
+//! IPv6 addresses and the dual-stack any address (QHostAddress::Any) get an
+//! IPv6 acceptor. It accepts IPv4 connections as well where the system
+//! doesn't restrict IPv6 sockets to IPv6 by default (IPV6_V6ONLY), as Linux.
+//! All other addresses, including the null address, get an IPv4 acceptor.
+//!
+//! \param   address   The address to listen on.
+//! \returns The IP version.
+//!
+//*****************************************************************************
+boost::asio::ip::tcp HttpServerWebcc::HttpServerWebccPrivate::IpProtocol(const QHostAddress& address)
+{
+   if (address.protocol() == QAbstractSocket::IPv6Protocol || address.protocol() == QAbstractSocket::AnyIPProtocol)
+      return boost::asio::ip::tcp::v6();
+   return boost::asio::ip::tcp::v4();
 }
 
 //*****************************************************************************
 //!
 //! \brief Checks if there is a registered endpoint for the request.
 //! If an endpoint was found that matches the request url path, then
-//! OnRequest() is called for this endpoint.
+//! OnRequest() is called for this endpoint. The lookup walks the route trie
+//! along the path segments, see RouteTrie::Find().
+//! The current route table snapshot is held until the request is processed,
+//! so concurrent changes of the endpoints don't affect it. Loading it isn't
+//! lock-free, std::atomic<std::shared_ptr> guards the reference count with a
+//! short internal lock in libstdc++ and MSVC. Writers only hold that lock
+//! to swap the pointer, never while they copy the table.
+//! The request is counted in the metrics of the matched route, see
+//! EndpointCounters.
 //!
 //! \param   request             The actual request.
 //! \returns webcc::ResponsePtr  Server response.
@@ -558,129 +1191,595 @@ HttpServerWebcc::HttpServerWebccPrivate::UrlMatch HttpServerWebcc::HttpServerWeb
 //*****************************************************************************
 webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::HandleRequest(webcc::RequestPtr requestData)
 {
-   QHash<HttpMethod, UrlMatch> matches;
+   EndpointCounters::Clock::time_point start = EndpointCounters::Clock::now();
+   InFlightGuard serverRequest(serverCounters.inFlight);
+
+   HttpMethod requestMethod = MapMethod(QString::fromStdString(requestData->method()));
+
+   // Refuse floods before any routing work
+   if (rateLimiter.Enabled()) {
+      // A request without a key isn't limited, a shared bucket would let one client starve all others
+      std::string key = RateLimitKey(*requestData, requestMethod);
+      if (key.empty() && !missingKeyWarned.exchange(true, std::memory_order_relaxed))
+         Warn(MissingRateLimitKey).Arg(serverName).Log();
+
+      int retryAfter = 0;
+      if (!key.empty() && !rateLimiter.Allow(key, retryAfter)) {
+         webcc::ResponsePtr response = webcc::ResponseBuilder{}.Code(429)();   // Too Many Requests
+         response->SetHeader("Retry-After", std::to_string(retryAfter));
+         serverCounters.Count(429);
+         return response;
+      }
+   }
 
-   for (auto it = endpoints.constBegin(); it != endpoints.constEnd(); it++) {
-      QString endpoint = it.value();
+   std::shared_ptr<const RouteTrie> snapshot = routes.load(std::memory_order_acquire);
 
-      UrlMatch match = Matches(endpoint, QString::fromStdString(requestData->url().path()));
-      if (match.match) {
-         HttpMethod method = it.key().second;
-         if (matches.contains(method)) {
-            if (matches[method].level > match.level)
-               matches[method] = match;
-            else if (matches[method].level == match.level)
-               ThrowUnknownEx();       // This shouldn't happen, because same level should be barred by HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint()
+   RouteTrie::Match match;
+   RouteTrie::Lookup lookup = snapshot->Find(requestData->url().path(), requestMethod, match);
+
+   EndpointCounters& counters = lookup == RouteTrie::Found ? *match.route->counters : serverCounters.unmatched;
+   InFlightGuard endpointRequest(counters.inFlight);
+   counters.Record(EndpointCounters::Routing, EndpointCounters::Clock::now() - start);
+
+   webcc::ResponsePtr response;
+   switch (lookup) {
+      case RouteTrie::Found:
+         if (match.route->kind == RouteTrie::Route::CallbackRoute) {
+            response = Admit(match, requestMethod, requestData, start);
          } else {
-            matches[method] = match;   // First match for this request method
+            EndpointCounters::Clock::time_point handlerStart = EndpointCounters::Clock::now();
+            switch (match.route->kind) {
+               case RouteTrie::Route::FileRoute: response = ServeFile(match, requestMethod, requestData); break;
+               case RouteTrie::Route::EventRoute: response = ServeEvents(match); break;
+               default: response = ServeMetrics(); break;
+            }
+            counters.Record(EndpointCounters::Handler, EndpointCounters::Clock::now() - handlerStart);
          }
-      }
-   }
-
-   // Match found?
-   if (matches.count() > 0) {
-      HttpMethod requestMethod = MapMethod(QString::fromStdString(requestData->method()));
-      if (matches.contains(requestMethod))
-         return ProcessRequest(matches[requestMethod], requestData);
-      else if (matches.contains(HttpMethod::ALL))
-         return ProcessRequest(matches[HttpMethod::ALL], requestData);
-      else
-         return webcc::ResponseBuilder{}.Code(405)();   // Method Not Allowed
+         break;
+      case RouteTrie::MethodNotAllowed:
+         response = webcc::ResponseBuilder{}.Code(405)();   // Method Not Allowed
+         break;
+      default:
+         response = webcc::ResponseBuilder{}.NotFound()();
+         break;
    }
 
-   return webcc::ResponseBuilder{}.NotFound()();
+   int statusCode = response->status();
+   counters.Finish(statusCode, BodySize(*requestData), BodySize(*response));
+   serverCounters.Count(statusCode);
+   return response;
 }
 
 //*****************************************************************************
 //!
-//! \brief Process a request for an endpoint.
-//! Transforms all data for the OnRequest() callback and returns a
-//! QHttpServerResponse to be returned to the client.
+//! \brief Admits a request to a callback endpoint or refuses it.
+//! Requests are refused while the server is overloaded, unless the endpoint
+//! is critical, and if the endpoint has no free slot, see AdmissionGate.
+//! Both are decided before the request is converted, so refusing is cheap.
+//! The latency of the admitted requests, including the wait for a slot,
+//! feeds the load shedding.
 //!
 //! \param   match               Match info, including the matched endpoint.
+//! \param   method              Request method.
 //! \param   requestData         Actual request data.
-//! \param   url                 URL that was called.
-//! \returns QHttpServerResponse Server response to be returned to the client.
+//! \param   start               When the request was received by the view.
+//! \returns webcc::ResponsePtr  Server response, 503 if the request was refused.
 //!
 //*****************************************************************************
-webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ProcessRequest(const UrlMatch& match, webcc::RequestPtr requestData)
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::Admit(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData, EndpointCounters::Clock::time_point start)
 {
-   // Determine query component parameters
-   webcc::UrlQuery urlQuery = requestData->query();
-   QHash<QString, QString> query;
-   for (size_t i = 0; i < urlQuery.Size(); i++) {
-      webcc::UrlQuery::Parameter parameter = urlQuery.Get(i);
-      query.insert(QString::fromStdString(parameter.first), QString::fromStdString(parameter.second));
+   const RouteTrie::Route& route = *match.route;
+   if (!route.options.critical && shedder.Overloaded()) {
+      shedder.Shed();
+      route.counters->rejected.fetch_add(1, std::memory_order_relaxed);
+      return Unavailable(shedder.Options().retryAfter);
    }
 
-   // Determine headers
-   webcc::Headers requestHeaders = requestData->headers();
-   QHash<QString, QString> headers;
-   for (size_t i = 0; i < requestHeaders.size(); i++) {
-      webcc::Header header = requestHeaders.Get(i);
-      headers.insert(QString::fromStdString(header.first), QString::fromStdString(header.second));
+   if (route.admission && !route.admission->Enter()) {
+      route.counters->rejected.fetch_add(1, std::memory_order_relaxed);
+      return Unavailable(shedder.Options().retryAfter);
    }
 
-   PathInfo path{
-      QString::fromStdString(requestData->url().path()),
-      match.pathVariables,
-      match.multiLevel,
-      query
-   };
+   webcc::ResponsePtr response;
+   {
+      AdmissionGate::Slot slot(route.admission.get());
+      response = ProcessRequest(match, method, requestData);
+   }
+   shedder.Record(EndpointCounters::Clock::now() - start);
+   return response;
+}
 
-   HttpRequest request;
-   request.method = MapMethod(QString::fromStdString(requestData->method()));
-   request.headers = headers;
-   request.body = QByteArray::fromStdString(requestData->data()); // TODO: Do we always get a StringBody?
+//*****************************************************************************
+//!
+//! \brief The key of the token bucket of a request.
+//! The client header lists the client and the proxies the request passed,
+//! see RateLimiter::Client().
+//!
+//! \param   requestData  Actual request data.
+//! \param   method       Request method.
+//! \returns std::string  The key, empty if the request has none.
+//!
+//*****************************************************************************
+std::string HttpServerWebcc::HttpServerWebccPrivate::RateLimitKey(const webcc::Request& requestData, HttpMethod method)
+{
+   const RateLimitOptions& options = rateLimiter.Options();
+   switch (options.key) {
+      case RateLimitOptions::PathKey:
+         return requestData.url().path();
+      case RateLimitOptions::CustomKey: {
+         RouteTrie::Match none;
+         HttpRequestViewWebcc request(requestData, none, method, serverName);
+         return options.keyExtractor ? options.keyExtractor(request) : std::string();
+      }
+      default: {
+         bool found = false;
+         const std::string& forwarded = requestData.GetHeader(options.clientHeader.constData(), &found);
+         return std::string(RateLimiter::Client(forwarded, options.trustedProxies));
+      }
+   }
+}
 
-   QString url = serverName + QString::fromStdString(requestData->url().path());
-   if (!requestData->url().query().empty()) {
-      url += "?" + QString::fromStdString(requestData->url().query());
+//*****************************************************************************
+//!
+//! \brief Identity of a request for coalescing.
+//! Consists of route, method, path and query, which includes the path
+//! variables, and the values of EndpointOptions::coalesceHeaders. Requests
+//! with credentials not in the key get none, they mustn't see the response
+//! of another user, see ResponseCache::CarriesCredentials().
+//!
+//! \param   match        Match info, including the matched endpoint.
+//! \param   method       Request method.
+//! \param   request      The request.
+//! \returns QByteArray   The key, empty if the request can't be coalesced.
+//!
+//*****************************************************************************
+QByteArray HttpServerWebcc::HttpServerWebccPrivate::CoalescingKey(const RouteTrie::Match& match, HttpMethod method, const HttpRequestView& request)
+{
+   const QList<QByteArray>& headers = match.route->options.coalesceHeaders;
+   if (ResponseCache::CarriesCredentials(request, headers))
+      return QByteArray();
+
+   QByteArray key = ResponseCache::Key(request.Path(), request.QueryString());
+   key += '\n' + QByteArray::number(int(method)) + ' ' + match.route->endpoint.toUtf8();
+   for (const QByteArray& header : headers) {
+      std::string_view value = request.Header(std::string_view(header.constData(), std::size_t(header.size())));
+      key += '\n' + header + ": ";
+      key.append(value.data(), qsizetype(value.size()));
    }
+   return key;
+}
 
-   // Call callback
-   HttpResponse httpResponse = parent->OnRequest(match.endpoint, url, path, request);
+//*****************************************************************************
+//! 503 Service Unavailable, telling the client when to retry.
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::Unavailable(int retryAfter)
+{
+   webcc::ResponsePtr response = webcc::ResponseBuilder{}.Code(503)();   // Service Unavailable
+   response->SetHeader("Retry-After", std::to_string(retryAfter));
+   return response;
+}
 
-   // Verfiy status code, QHttpServer only allows a certain set of status codes.
-   // If we want to allow all status codes, a solution might be to create a derived class of QHttpServerResponse, that
-   // overrides the virutal write(QHttpServerResponder) function and writes the status line itself.
-   int code = httpResponse.statusCode;
-   if (!(/*(code >= 100 && code <= 102) ||  */  // 1xx status codes are not supported for now. We would need a solution to call the callback repeatedly otherwise the HttpClient will block indefinitely when Wait() is called.
-         (code >= 200 && code <= 208) || code == 226 ||
-         (code >= 300 && code <= 308 && code != 306) ||
+//*****************************************************************************
+//! Size of the body of a request or response, 0 if it isn't known.
+//*****************************************************************************
+qint64 HttpServerWebcc::HttpServerWebccPrivate::BodySize(const webcc::Message& message)
+{
+   return message.body() ? qint64(message.body()->GetSize()) : 0;
+}
+
+//*****************************************************************************
+//!
+//! \brief Answers a request to the metrics endpoint.
+//!
+//! \returns webcc::ResponsePtr  The metrics in the Prometheus text format.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ServeMetrics()
+{
+   webcc::ResponsePtr response = webcc::ResponseBuilder{}
+      .Code(200)
+      .MediaType("text/plain; version=0.0.4")
+      .Utf8()
+      ();
+   response->SetBody(std::make_shared<BufferBody>(ServerCounters::Prometheus(MetricsSnapshot())), true);
+   return response;
+}
+
+//*****************************************************************************
+//!
+//! \brief Answers a request to an event endpoint.
+//! The client is subscribed to the events of the endpoint and the response
+//! stays open, see EventStreamBody. If the endpoint has as many subscribers
+//! as it may have, or the subscribers of all endpoints hold every loop
+//! thread started for them, the request is refused.
+//!
+//! \param   match               Match info, including the matched endpoint.
+//! \returns webcc::ResponsePtr  The event stream, or 503 if there are too many subscribers.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ServeEvents(const RouteTrie::Match& match)
+{
+   // Every subscriber blocks a loop thread. A subscriber that would block one of the #loops threads is refused, so the
+   // other connections always keep as many loop threads as Loops() reports.
+   std::shared_ptr<EventSubscription> subscription;
+   {
+      QMutexLocker lock(&publishing);
+      int subscribers = 0;
+      for (const std::shared_ptr<EventChannel>& channel : std::as_const(eventChannels))
+         subscribers += channel->Subscribers();
+
+      std::shared_ptr<EventChannel> channel = eventChannels.value(match.route->endpoint);
+      if (channel && subscribers < streamLoops)
+         subscription = channel->Subscribe();
+   }
+   if (!subscription)
+      return Unavailable(5);
+
+   webcc::ResponsePtr response = webcc::ResponseBuilder{}
+      .Code(200)
+      .MediaType("text/event-stream")
+      .Utf8()
+      ();
+   response->SetHeader("Cache-Control", "no-cache");
+   response->SetHeader("Transfer-Encoding", "chunked");
+   response->SetBody(std::make_shared<EventStreamBody>(std::move(subscription)), false);
+   return response;
+}
+
+//*****************************************************************************
+//!
+//! \brief Answers a request to a file endpoint.
+//! Ranges up to 64 KiB are read into a buffer, larger ones are read window
+//! by window while they are sent, see ProducerBody. Files aren't mapped: a
+//! file truncated while it is sent would fault the process, a read just
+//! comes up short and ends that response. Supports conditional
+//! requests (If-None-Match, If-Modified-Since) and a single byte range
+//! (Range, If-Range). A directory is answered with its index.html.
+//!
+//! \param   match               Match info, including the matched endpoint.
+//! \param   method              Request method, GET or HEAD.
+//! \param   requestData         Actual request data.
+//! \returns webcc::ResponsePtr  Server response to be returned to the client.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ServeFile(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData)
+{
+   QString path = StaticFiles::Resolve(match.route->directory, match.multiLevel);
+   if (path.isNull())
+      return webcc::ResponseBuilder{}.NotFound()();
+
+   std::shared_ptr<const StaticFiles::FileInfo> info = staticFiles.Info(path);
+   if (info->directory)
+      info = staticFiles.Info(path + "/index.html");
+   if (!info->exists)
+      return webcc::ResponseBuilder{}.NotFound()();
+
+   // The metadata may be up to a TTL old. The size of the open file is compared with it, so a file that changed in the
+   // meantime isn't sent with a wrong length. Stale metadata is read again.
+   std::shared_ptr<QFile> file;
+   if (method == GET) {
+      file = std::make_shared<QFile>(info->path);
+      if (!file->open(QIODevice::ReadOnly))
+         return webcc::ResponseBuilder{}.NotFound()();
+      if (file->size() != info->size) {
+         info = staticFiles.Refresh(info->path);
+         if (!info->exists)
+            return webcc::ResponseBuilder{}.NotFound()();
+         if (file->size() != info->size)
+            return webcc::ResponseBuilder{}.Code(503)();   // Service Unavailable, the file is being written
+      }
+   }
+
+   // If-None-Match takes precedence over If-Modified-Since, see RFC 9110, 13.2.2.
+   bool found = false;
+   bool notModified = false;
+   const std::string& ifNoneMatch = requestData->GetHeader("If-None-Match", &found);
+   if (found) {
+      notModified = ResponseCache::Matches(ifNoneMatch, info->etag);
+   } else {
+      const std::string& ifModifiedSince = requestData->GetHeader("If-Modified-Since", &found);
+      if (found) {
+         QDateTime since = StaticFiles::ParseHttpDate(ifModifiedSince);
+         notModified = since.isValid() && info->lastModified <= since;
+      }
+   }
+
+   if (notModified) {
+      webcc::ResponsePtr response = webcc::ResponseBuilder{}.Code(304)();   // Not Modified
+      response->SetHeader("ETag", info->etag.toStdString());
+      response->SetHeader("Last-Modified", info->lastModifiedHttp.toStdString());
+      return response;
+   }
+
+   // A range is only served if the client's copy is still current, otherwise the whole file is sent.
+   int code = 200;
+   qint64 first = 0;
+   qint64 last = info->size - 1;
+   const std::string& range = requestData->GetHeader("Range", &found);
+   if (found && method == GET && range.compare(0, 6, "bytes=") == 0 && range.find(',') == std::string::npos) {
+      const std::string& ifRange = requestData->GetHeader("If-Range", &found);
+      if (!found || ifRange == info->etag.toStdString() || ifRange == info->lastModifiedHttp.toStdString()) {
+         if (!StaticFiles::ParseRange(range, info->size, first, last)) {
+            webcc::ResponsePtr response = webcc::ResponseBuilder{}.Code(416)();   // Range Not Satisfiable
+            response->SetHeader("Content-Range", "bytes */" + std::to_string(info->size));
+            return response;
+         }
+         code = 206;   // Partial Content
+      }
+   }
+   qint64 length = info->size > 0 ? last - first + 1 : 0;
+
+   webcc::ResponsePtr response = webcc::ResponseBuilder{}
+      .Code(code)
+      .MediaType(std::string_view(info->contentType.constData(), info->contentType.size()))
+      ();
+
+   static const qint64 maxReadSize = 64 * 1024;   // Larger ranges are streamed through the window
+
+   if (method == HEAD) {
+      response->SetHeader("Content-Length", std::to_string(length));
+   } else if (length > 0 && length <= maxReadSize) {
+      // A copy of a small range is cheap and can't fault if the file is truncated while it's sent.
+      auto buffer = std::make_shared<std::string>(std::size_t(length), '\0');
+      if (!file->seek(first) || file->read(buffer->data(), length) != length)
+         return webcc::ResponseBuilder{}.Code(503)();   // Service Unavailable, the file was truncated
+      response->SetBody(std::make_shared<BufferBody>(std::move(buffer)), true);
+   } else if (length > 0) {
+      // Only one window is held in memory. A truncated file ends the body early, the client sees the short response.
+      if (!file->seek(first))
+         return webcc::ResponseBuilder{}.Code(503)();   // Service Unavailable, the file was truncated
+      response->SetBody(std::make_shared<ProducerBody>(file, length, streamingWindow, 0), true);   // A file has its data at hand
+   }
+
+   response->SetHeader("ETag", info->etag.toStdString());
+   response->SetHeader("Last-Modified", info->lastModifiedHttp.toStdString());
+   response->SetHeader("Accept-Ranges", "bytes");
+   if (code == 206)
+      response->SetHeader("Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(info->size));
+
+   return response;
+}
+
+//*****************************************************************************
+//!
+//! \brief Process a request for an endpoint.
+//! Passes a view of the request to the OnRequest() callback and returns a
+//! webcc::Response to be returned to the client. The request data is only
+//! converted if the callback asks for it.
+//! GET requests to endpoints with EndpointOptions::cacheTtl are answered from
+//! the response cache while the entry is fresh, with 304 Not Modified if the
+//! client's If-None-Match header matches.
+//! Bodies of endpoints with EndpointOptions::compressionThreshold are
+//! compressed with the coding the client accepts, see Compress().
+//!
+//! \param   match               Match info, including the matched endpoint.
+//! \param   method              Request method.
+//! \param   requestData         Actual request data.
+//! \returns webcc::ResponsePtr  Server response to be returned to the client.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ProcessRequest(const RouteTrie::Match& match, HttpMethod method, webcc::RequestPtr requestData)
+{
+   const QString& endpoint = match.route->endpoint;
+
+   HttpRequestViewWebcc request(*requestData, match, method, serverName);
+
+   // Reject request bodies exceeding the limit of the endpoint. The announced size is checked first, so a spooled body
+   // isn't touched. Webcc's View::Stream() gets the method only, not the headers, so the body can't be refused before
+   // it is received: it was buffered or spooled already and used its memory or disk space.
+   const EndpointOptions& options = match.route->options;
+   if (options.maxRequestBodySize >= 0 && (request.DeclaredBodySize() > options.maxRequestBodySize || request.BodySize() > options.maxRequestBodySize))
+      return webcc::ResponseBuilder{}.Code(413)();   // Payload Too Large
+
+   // A spooled body that can't be read would reach the callback as an empty body.
+   if (!request.OpenBody()) {
+      Ex(UnreadableRequestBody).Arg(serverName).Arg(endpoint).Arg(request.BodyFilePath()).Log();
+      return webcc::ResponseBuilder{}.InternalServerError()();
+   }
+
+   // Answer from the cache without calling the callback. Entries of an endpoint shadowed by a newer one are ignored.
+   // Requests with credentials bypass the cache, their responses may be for their user only.
+   QByteArray cacheKey;
+   std::shared_ptr<const ResponseCache::Entry> entry;
+   if (options.cacheTtl > 0 && (method == GET || method == HEAD) && !ResponseCache::CarriesCredentials(request)) {
+      cacheKey = ResponseCache::Key(requestData->url().path(), requestData->url().query());
+      entry = responseCache.Find(cacheKey);
+      if (entry && entry->endpoint != endpoint)
+         entry.reset();
+   }
+
+   HttpResponse httpResponse;
+   if (entry) {
+      httpResponse = entry->response;   // A HEAD request keeps the body until BuildResponse() took its size
+   } else {
+      // Call callback. Webcc expects the response when the view returns, so an asynchronous callback still blocks this
+      // worker thread until it completes or times out. The I/O loops keep serving other connections meanwhile.
+      auto call = [&](HttpResponse& response) {
+         if (options.asynchronous) {
+            auto completion = std::make_shared<HttpCompletion>();
+            parent->OnRequestAsync(endpoint, request, completion);
+            return HttpCompletion::Wait(std::move(completion), options.asyncTimeout, response);
+         }
+         response = parent->OnRequest(endpoint, request);
+         return true;
+      };
+
+      // Identical requests arriving while the callback runs wait for its response instead of calling it again.
+      EndpointCounters::Clock::time_point handlerStart = EndpointCounters::Clock::now();
+      bool shared = false;
+      QByteArray flightKey = options.coalesce && (method == GET || method == HEAD) ? CoalescingKey(match, method, request) : QByteArray();
+      bool completed = !flightKey.isEmpty()
+         ? flights.Run(flightKey, call, options.coalesceTimeout, httpResponse, shared)
+         : call(httpResponse);
+      if (!completed)
+         return webcc::ResponseBuilder{}.Code(504)();   // Gateway Timeout
+      match.route->counters->Record(EndpointCounters::Handler, EndpointCounters::Clock::now() - handlerStart);
+
+      // Head request should not return a response body. Only its headers and its size are sent, see BuildResponse().
+      if (method == HEAD && httpResponse.BodySize() != 0)
+         Warn(HeadWithBody).Arg(serverName).Arg(endpoint).Log();
+
+      if (shared) {
+         match.route->counters->coalesced.fetch_add(1, std::memory_order_relaxed);
+
+         // The request that called the callback has cached the response already, with its entity tag.
+         if (!cacheKey.isEmpty()) {
+            entry = responseCache.Find(cacheKey);
+            if (entry && entry->endpoint == endpoint && method == GET)
+               httpResponse = entry->response;
+            else
+               entry.reset();
+         }
+      }
+
+      // Cache the response, so the callback isn't called again until the entry expires or is invalidated.
+      if (!shared && !cacheKey.isEmpty() && method == GET && httpResponse.statusCode == 200 && !httpResponse.IsStreamed() && ResponseCache::Storable(httpResponse)) {
+         auto added = std::make_shared<ResponseCache::Entry>();
+         added->endpoint = endpoint;
+         added->etag = httpResponse.headers.value("ETag").toUtf8();   // The callback may set an entity tag of its own.
+         if (added->etag.isEmpty()) {
+            added->etag = ResponseCache::ETag(httpResponse);
+            httpResponse.headers["ETag"] = QString::fromLatin1(added->etag);
+         }
+         added->response = httpResponse;   // Shares the body, see HttpResponse::body
+         added->expiry = QDeadlineTimer(options.cacheTtl);
+         responseCache.Insert(cacheKey, added);
+         entry = std::move(added);
+      }
+   }
+
+   EndpointCounters::Clock::time_point serializationStart = EndpointCounters::Clock::now();
+
+   // HEAD requests are negotiated like GET requests, so they get the same Vary, Content-Encoding, Content-Length and ETag.
+   if (options.compressionThreshold >= 0)
+      Compress(httpResponse, Compression::Negotiate(requestData->GetHeader("Accept-Encoding")), options, entry, cacheKey);
+
+   webcc::ResponsePtr response;
+   if (entry && ResponseCache::Matches(requestData->GetHeader("If-None-Match"), httpResponse.headers.value("ETag").toUtf8()))
+      response = NotModified(httpResponse);
+   else
+      response = BuildResponse(endpoint, method, httpResponse, options.streamReadTimeout);
+
+   match.route->counters->Record(EndpointCounters::Serialization, EndpointCounters::Clock::now() - serializationStart);
+   return response;
+}
+
+//*****************************************************************************
+//!
+//! \brief Compresses a response body with the content coding the client accepts.
+//! Bodies below EndpointOptions::compressionThreshold, streamed bodies and
+//! bodies the callback already encoded are sent as they are. The compressed
+//! body of a cached response is kept with the cache entry, so every variant
+//! is compressed only once. Its entity tag gets the coding as suffix, because
+//! the variants differ in their bytes.
+//!
+//! \param   httpResponse  The response to compress.
+//! \param   encoding      Content coding negotiated with the client, empty if none.
+//! \param   options       Options of the endpoint.
+//! \param   entry         Cache entry of the response, null if it isn't cached.
+//! \param   cacheKey      Cache key of the entry.
+//!
+//*****************************************************************************
+void HttpServerWebcc::HttpServerWebccPrivate::Compress(HttpResponse& httpResponse, const QByteArray& encoding, const EndpointOptions& options, const std::shared_ptr<const ResponseCache::Entry>& entry, const QByteArray& cacheKey)
+{
+   if (httpResponse.IsStreamed() || httpResponse.BodySize() < qMax(options.compressionThreshold, 1) || httpResponse.headers.contains("Content-Encoding"))
+      return;
+
+   // Caches between server and client have to keep the variants apart.
+   QString vary = httpResponse.headers.value("Vary");
+   httpResponse.headers["Vary"] = vary.isEmpty() ? QString("Accept-Encoding") : vary + ", Accept-Encoding";
+
+   if (encoding.isEmpty())
+      return;
+
+   HttpServer::SharedBuffer compressed = entry ? entry->Variant(encoding) : nullptr;
+   if (!compressed) {
+      QByteArrayView body = httpResponse.sharedBody
+         ? QByteArrayView(httpResponse.sharedBody->data(), qsizetype(httpResponse.sharedBody->size()))
+         : QByteArrayView(httpResponse.body);
+      compressed = compression.Compress(encoding, options.compressionLevel, body);
+      if (!compressed)
+         return;   // Send the body uncompressed
+
+      if (entry) {
+         entry->AddVariant(encoding, compressed);
+         responseCache.Update(cacheKey, entry);
+      }
+   }
+
+   httpResponse.sharedBody = std::move(compressed);
+   httpResponse.body.clear();
+   httpResponse.headers["Content-Encoding"] = QString::fromLatin1(encoding);
+
+   QString etag = httpResponse.headers.value("ETag");
+   if (etag.endsWith('"'))
+      httpResponse.headers["ETag"] = etag.chopped(1) + '-' + QString::fromLatin1(encoding) + '"';
+}
+
+//*****************************************************************************
+//!
+//! \brief Converts the response of a callback to a webcc::Response.
+//! The body is handed over to webcc without copying it. A response to a HEAD
+//! request gets the Content-Length of its body, but the body isn't sent.
+//!
+//! \param   endpoint            The endpoint that produced the response.
+//! \param   method              Request method.
+//! \param   httpResponse        The response. Its body is moved out.
+//! \param   readTimeout         Milliseconds to wait for data of a sequential body device.
+//! \returns webcc::ResponsePtr  Server response to be returned to the client.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::BuildResponse(const QString& endpoint, HttpMethod method, HttpResponse& httpResponse, int readTimeout)
+{
+   // Verfiy status code, QHttpServer only allows a certain set of status codes.
+   // If we want to allow all status codes, a solution might be to create a derived class of QHttpServerResponse, that
+   // overrides the virutal write(QHttpServerResponder) function and writes the status line itself.
+   int code = httpResponse.statusCode;
+   if (!(/*(code >= 100 && code <= 102) ||  */  // 1xx status codes are not supported for now. We would need a solution to call the callback repeatedly otherwise the HttpClient will block indefinitely when Wait() is called.
+         (code >= 200 && code <= 208) || code == 226 ||
+         (code >= 300 && code <= 308 && code != 306) ||
          (code >= 400 && code <= 417) ||
          (code >= 421 && code <= 424) || code == 426 ||
          (code >= 428 && code <= 429) || code == 431 || code == 451 ||
          (code >= 500 && code <= 508) || code == 510 || code == 511
       )) {
-      Ex(InvalidStatusCode).Arg(serverName).Arg(match.endpoint).Arg(code).Log();
+      Ex(InvalidStatusCode).Arg(serverName).Arg(endpoint).Arg(code).Log();
       return webcc::ResponseBuilder{}.InternalServerError()();
    }
 
-   // Head request should not return a response body.
-   if (request.method & HttpServer::HEAD && httpResponse.body.size() > 0) {
-      Warn(HeadWithBody).Arg(serverName).Arg(match.endpoint).Log();
-   }
-
-
-   std::string_view contentType("application/octet-stream"); // Default Content-Type, see RFC 2616 7.2.1
-   if (httpResponse.body.size() == 0)
+   QByteArray contentType("application/octet-stream"); // Default Content-Type, see RFC 2616 7.2.1
+   if (httpResponse.BodySize() == 0)
       contentType = "application/x-empty";
    if (httpResponse.headers.contains("Content-Type")) // If the header is explicitly set, overwrite any default value.
-      contentType = httpResponse.headers["Content-Type"].toUtf8().constData();
+      contentType = httpResponse.headers["Content-Type"].toUtf8();
 
    webcc::ResponsePtr response = webcc::ResponseBuilder{}
       .Code(httpResponse.statusCode)
-      .MediaType(contentType)
-      .Body(httpResponse.body.toStdString())
+      .MediaType(std::string_view(contentType.constData(), contentType.size()))
       .Utf8()
       ();
 
+   // Hand the body over without copying it. The body keeps a reference to the buffer until it was sent.
+   if (method == HEAD) {
+      if (httpResponse.BodySize() >= 0)
+         response->SetHeader("Content-Length", std::to_string(httpResponse.BodySize()));
+   } else if (httpResponse.IsStreamed()) {
+      auto body = httpResponse.bodyProducer
+         ? std::make_shared<ProducerBody>(std::move(httpResponse.bodyProducer), httpResponse.contentLength, streamingWindow)
+         : std::make_shared<ProducerBody>(std::move(httpResponse.bodyDevice), httpResponse.contentLength, streamingWindow, readTimeout);
+      response->SetBody(body, !body->IsChunked());
+      if (body->IsChunked())
+         response->SetHeader("Transfer-Encoding", "chunked");
+   } else if (httpResponse.sharedBody)
+      response->SetBody(std::make_shared<BufferBody>(std::move(httpResponse.sharedBody)), true);
+   else
+      response->SetBody(std::make_shared<BufferBody>(httpResponse.body), true);
+
    // Set headers
    for (QHash<QString, QString>::iterator i = httpResponse.headers.begin(); i != httpResponse.headers.end(); i++) {
       QString header = i.key();
       if (reservedHeaders.contains(header)) {
-         Ex(ReserverHeader).Arg(serverName).Arg(match.endpoint).Arg(header).Log();
+         Ex(ReserverHeader).Arg(serverName).Arg(endpoint).Arg(header).Log();
          return webcc::ResponseBuilder{}.InternalServerError()();
       }
 
@@ -690,6 +1789,27 @@ webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::ProcessRequest(const
    return response;
 }
 
+//*****************************************************************************
+//!
+//! \brief Builds a 304 Not Modified response for a cached response.
+//! Carries the headers RFC 7232, 4.1 asks for, but no body.
+//!
+//! \param   cached              The cached response.
+//! \returns webcc::ResponsePtr  Server response to be returned to the client.
+//!
+//*****************************************************************************
+webcc::ResponsePtr HttpServerWebcc::HttpServerWebccPrivate::NotModified(const HttpResponse& cached)
+{
+   webcc::ResponsePtr response = webcc::ResponseBuilder{}.Code(304)();   // Not Modified
+
+   for (const char* header : { "ETag", "Cache-Control", "Expires", "Vary", "Content-Location" }) {
+      auto value = cached.headers.constFind(header);
+      if (value != cached.headers.constEnd())
+         response->SetHeader(header, value->toUtf8().data());
+   }
+   return response;
+}
+
 //*****************************************************************************
 //!
 //! \brief Maps the HttpMethod to a QString.
@@ -762,6 +1882,67 @@ EventMsg HttpServerWebcc::msgInvalidPortEx = EventMsg({
    { "de-DE", "'%1' ist keine gültige Portnummer. Der Wert muss zwischen 0 und 65535 liegen." }
 });
 
+EventMsg HttpServerWebcc::msgInvalidThreadCountEx = EventMsg({
+   { "en-US", "'%1' is not a valid number of threads. At least one thread is required." },
+   { "de-DE", "'%1' ist keine gültige Anzahl an Threads. Es wird mindestens ein Thread benötigt." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidStreamingWindowEx = EventMsg({
+   { "en-US", "'%1' is not a valid streaming window size. The window has to be at least 1 byte." },
+   { "de-DE", "'%1' ist keine gültige Größe für das Streaming-Fenster. Das Fenster muss mindestens 1 Byte groß sein." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidCacheSizeEx = EventMsg({
+   { "en-US", "'%1' is not a valid response cache size. The size can't be negative." },
+   { "de-DE", "'%1' ist keine gültige Größe für den Antwort-Cache. Die Größe darf nicht negativ sein." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidTlsOptionsEx = EventMsg({
+   { "en-US", "Invalid TLS settings: The session cache size can't be negative and the session timeout has to be at least 1 second." },
+   { "de-DE", "Ungültige TLS-Einstellungen: Die Größe des Session-Caches darf nicht negativ sein und das Session-Timeout muss mindestens 1 Sekunde betragen." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidConnectionOptionsEx = EventMsg({
+   { "en-US", "Invalid connection settings: The connection limit can't be negative." },
+   { "de-DE", "Ungültige Verbindungs-Einstellungen: Das Verbindungslimit darf nicht negativ sein." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidSheddingOptionsEx = EventMsg({
+   { "en-US", "Invalid load shedding settings: Limits and retry time can't be negative." },
+   { "de-DE", "Ungültige Lastabwurf-Einstellungen: Limits und Wiederholzeit dürfen nicht negativ sein." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidRateLimitOptionsEx = EventMsg({
+   { "en-US", "Invalid rate limit settings: The rate can't be negative, the burst has to be at least 1, a client key needs a client header and at least 1 trusted proxy and a custom key needs a key extractor." },
+   { "de-DE", "Ungültige Rate-Limit-Einstellungen: Die Rate darf nicht negativ sein, der Burst muss mindestens 1 sein, ein Client-Schlüssel braucht einen Client-Header und mindestens einen vertrauenswürdigen Proxy und ein eigener Schlüssel braucht eine Schlüssel-Funktion." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidEndpointOptionsEx = EventMsg({
+   { "en-US", "Invalid options for endpoint '%1': The asynchronous, coalescing and stream read timeouts have to be at least 1 millisecond, the concurrency limit, queue limit and queue timeout must not be negative." },
+   { "de-DE", "Ungültige Optionen für den Endpunkt '%1': Das asynchrone, das Coalescing- und das Stream-Lese-Timeout müssen mindestens 1 Millisekunde betragen, das Parallelitätslimit, das Warteschlangenlimit und das Warteschlangen-Timeout dürfen nicht negativ sein." }
+});
+
+EventMsg HttpServerWebcc::msgInvalidCpuEx = EventMsg({
+   { "en-US", "'%1' is not a valid CPU index. The CPU index has to be between 0 and %2." },
+   { "de-DE", "'%1' ist kein gültiger CPU-Index. Der Wert muss zwischen 0 und %2 liegen." }
+});
+
+//*****************************************************************************
+//! Raises an exception if one of the CPUs doesn't exist.
+//*****************************************************************************
+void HttpServerWebcc::ValidateCpus(const QList<int>& cpus)
+{
+#if defined(Q_OS_WIN)
+   int maxCpu = qMin(QThread::idealThreadCount(), int(sizeof(DWORD_PTR) * 8)) - 1;
+#else
+   int maxCpu = QThread::idealThreadCount() - 1;
+#endif
+   for (int cpu : cpus) {
+      if (cpu < 0 || cpu > maxCpu)
+         Ex(InvalidCpu).Arg(cpu).Arg(maxCpu).Raise();
+   }
+}
+
 HttpServerWebcc::HttpServerWebcc() :
    p(new HttpServerWebccPrivate(this)),
    protocol(HttpServer::HTTPS)
@@ -811,6 +1992,34 @@ void HttpServerWebcc::PortImpl(int port)
    HttpServerWebcc::port = port;
 }
 
+bool HttpServerWebcc::AddListenEndpointImpl(const ListenEndpoint& endpoint)
+{
+   QMutexLocker lock(&members);
+
+   QHostAddress hostAddress;
+   if (!hostAddress.setAddress(endpoint.address))
+      Ex(InvalidAddress).Arg(endpoint.address).Raise();
+   if (endpoint.port < 0 || endpoint.port > 65535)
+      Ex(InvalidPort).Arg(endpoint.port).Raise();
+   ValidateCpus(endpoint.cpus);
+
+   listenEndpoints.append(endpoint);
+   return true;
+}
+
+bool HttpServerWebcc::ClearListenEndpointsImpl()
+{
+   QMutexLocker lock(&members);
+   listenEndpoints.clear();
+   return true;
+}
+
+QList<HttpServer::ListenEndpoint> HttpServerWebcc::ListenEndpointsImpl()
+{
+   QMutexLocker lock(&members);
+   return QList<ListenEndpoint>{ { address.toString(), port } } + listenEndpoints;
+}
+
 bool HttpServerWebcc::IsHttpsImpl()
 {
    return p->IsHttps();
@@ -819,7 +2028,14 @@ bool HttpServerWebcc::IsHttpsImpl()
 bool HttpServerWebcc::StartImpl()
 {
    QMutexLocker lock(&members);
-   return p->Start(address, port, protocol);
+
+   // The ports of the endpoints are set to the actual ones.
+   QList<ListenEndpoint> endpoints = QList<ListenEndpoint>{ { address.toString(), port } } + listenEndpoints;
+   bool started = p->Start(endpoints, protocol);
+
+   port = endpoints.takeFirst().port;
+   listenEndpoints = endpoints;
+   return started;
 }
 
 bool HttpServerWebcc::StopImpl()
@@ -828,10 +2044,19 @@ bool HttpServerWebcc::StopImpl()
    return p->Stop();
 }
 
-bool HttpServerWebcc::AddEndpointImpl(const QString& endpoint, HttpServer::HttpMethod method)
+bool HttpServerWebcc::AddEndpointImpl(const QString& endpoint, HttpServer::HttpMethod method, const HttpServer::EndpointOptions& options)
 {
    QMutexLocker lock(&members);
-   return p->AddEndpoint(endpoint, method);
+   if (options.asyncTimeout < 1 || options.coalesceTimeout < 1 || options.streamReadTimeout < 1 || options.maxConcurrent < 0 || options.maxQueued < 0 || options.queueTimeout < 0)
+      Ex(InvalidEndpointOptions).Arg(endpoint).Raise();
+
+   return p->AddEndpoint(endpoint, method, options);
+}
+
+bool HttpServerWebcc::AddFileEndpointImpl(const QString& endpoint, const QString& directory)
+{
+   QMutexLocker lock(&members);
+   return p->AddFileEndpoint(endpoint, directory);
 }
 
 bool HttpServerWebcc::RemoveEndpointImpl(const QString& endpoint, HttpServer::HttpMethod method)
@@ -851,4 +2076,178 @@ bool HttpServerWebcc::SetPrivateKeyImpl(const QByteArray& keyData, HttpServer::S
    QMutexLocker lock(&members);
    return p->SetPrivateKey(keyData, encoding, algorithm, passphrase);
 }
-}
\ No newline at end of file
+
+bool HttpServerWebcc::ReloadCertificateImpl(const QByteArray& certificateData, const QByteArray& keyData, HttpServer::SslEncoding encoding, HttpServer::SslKeyAlgorithm algorithm, const QString& passphrase)
+{
+   QMutexLocker lock(&members);
+   return p->ReloadCertificate(certificateData, keyData, encoding, algorithm, passphrase);
+}
+
+bool HttpServerWebcc::TlsSettingsImpl(const TlsOptions& options)
+{
+   QMutexLocker lock(&members);
+   if (options.sessionCacheSize < 0 || options.sessionTimeout < 1)
+      Ex(InvalidTlsOptions).Raise();
+
+   p->TlsSettings(options);
+   return true;
+}
+
+HttpServer::TlsOptions HttpServerWebcc::TlsSettingsImpl()
+{
+   QMutexLocker lock(&members);
+   return p->TlsSettings();
+}
+
+bool HttpServerWebcc::ConnectionSettingsImpl(const ConnectionOptions& options)
+{
+   QMutexLocker lock(&members);
+   if (options.maxConnections < 0)
+      Ex(InvalidConnectionOptions).Raise();
+
+   p->ConnectionSettings(options);
+   return true;
+}
+
+HttpServer::ConnectionOptions HttpServerWebcc::ConnectionSettingsImpl()
+{
+   QMutexLocker lock(&members);
+   return p->ConnectionSettings();
+}
+
+bool HttpServerWebcc::LoadSheddingImpl(const SheddingOptions& options)
+{
+   QMutexLocker lock(&members);
+   if (options.maxCpuLoad < 0 || options.maxLatency < 0 || options.retryAfter < 0)
+      Ex(InvalidSheddingOptions).Raise();
+
+   p->LoadShedding(options);
+   return true;
+}
+
+HttpServer::SheddingOptions HttpServerWebcc::LoadSheddingImpl()
+{
+   QMutexLocker lock(&members);
+   return p->LoadShedding();
+}
+
+bool HttpServerWebcc::RateLimitImpl(const RateLimitOptions& options)
+{
+   QMutexLocker lock(&members);
+   if (options.rate < 0 || options.burst < 1 || (options.rate > 0 && options.key == RateLimitOptions::ClientKey && (options.clientHeader.isEmpty() || options.trustedProxies < 1)) || (options.key == RateLimitOptions::CustomKey && !options.keyExtractor))
+      Ex(InvalidRateLimitOptions).Raise();
+
+   p->RateLimit(options);
+   return true;
+}
+
+HttpServer::RateLimitOptions HttpServerWebcc::RateLimitImpl()
+{
+   QMutexLocker lock(&members);
+   return p->RateLimit();
+}
+
+bool HttpServerWebcc::ThreadsImpl(int workers, int loops)
+{
+   QMutexLocker lock(&members);
+   if (workers < 1)
+      Ex(InvalidThreadCount).Arg(workers).Raise();
+   if (loops < 1)
+      Ex(InvalidThreadCount).Arg(loops).Raise();
+
+   p->Threads(workers, loops);
+   return true;
+}
+
+int HttpServerWebcc::WorkersImpl()
+{
+   QMutexLocker lock(&members);
+   return p->Workers();
+}
+
+int HttpServerWebcc::LoopsImpl()
+{
+   QMutexLocker lock(&members);
+   return p->Loops();
+}
+
+bool HttpServerWebcc::CpuAffinityImpl(const QList<int>& cpus)
+{
+   QMutexLocker lock(&members);
+   ValidateCpus(cpus);
+
+   p->CpuAffinity(cpus);
+   return true;
+}
+
+QList<int> HttpServerWebcc::CpuAffinityImpl()
+{
+   QMutexLocker lock(&members);
+   return p->CpuAffinity();
+}
+
+bool HttpServerWebcc::StreamingWindowImpl(qint64 bytes)
+{
+   QMutexLocker lock(&members);
+   if (bytes < 1)
+      Ex(InvalidStreamingWindow).Arg(QString::number(bytes)).Raise();
+
+   p->StreamingWindow(bytes);
+   return true;
+}
+
+qint64 HttpServerWebcc::StreamingWindowImpl()
+{
+   QMutexLocker lock(&members);
+   return p->StreamingWindow();
+}
+
+bool HttpServerWebcc::ResponseCacheSizeImpl(qint64 bytes)
+{
+   QMutexLocker lock(&members);
+   if (bytes < 0)
+      Ex(InvalidCacheSize).Arg(QString::number(bytes)).Raise();
+
+   p->ResponseCacheSize(bytes);
+   return true;
+}
+
+qint64 HttpServerWebcc::ResponseCacheSizeImpl()
+{
+   QMutexLocker lock(&members);
+   return p->ResponseCacheSize();
+}
+
+void HttpServerWebcc::InvalidateCacheImpl(const QString& endpoint)
+{
+   QMutexLocker lock(&members);
+   p->InvalidateCache(endpoint);
+}
+
+HttpServer::CompressionStatistics HttpServerWebcc::CompressionStatsImpl()
+{
+   return p->CompressionStats();
+}
+
+HttpServer::Metrics HttpServerWebcc::MetricsSnapshotImpl()
+{
+   return p->MetricsSnapshot();
+}
+
+bool HttpServerWebcc::AddMetricsEndpointImpl(const QString& endpoint)
+{
+   QMutexLocker lock(&members);
+   return p->AddMetricsEndpoint(endpoint);
+}
+
+bool HttpServerWebcc::AddEventEndpointImpl(const QString& endpoint, int maxSubscribers)
+{
+   QMutexLocker lock(&members);
+   return p->AddEventEndpoint(endpoint, maxSubscribers);
+}
+
+int HttpServerWebcc::PublishEventImpl(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id)
+{
+   return p->PublishEvent(endpoint, data, event, id);
+}
+}
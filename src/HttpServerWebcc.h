@@ -80,18 +80,47 @@ protected:
    virtual void AddressImpl(const QString& address);
    virtual int PortImpl();
    virtual void PortImpl(int port);
+   virtual bool AddListenEndpointImpl(const ListenEndpoint& endpoint);
+   virtual bool ClearListenEndpointsImpl();
+   virtual QList<ListenEndpoint> ListenEndpointsImpl();
 
    virtual bool IsHttpsImpl();
 
    virtual bool StartImpl();
    virtual bool StopImpl();
 
-   virtual bool AddEndpointImpl(const QString& endpoint, HttpMethod method);
+   virtual bool AddEndpointImpl(const QString& endpoint, HttpMethod method, const EndpointOptions& options);
+   virtual bool AddFileEndpointImpl(const QString& endpoint, const QString& directory);
    virtual bool RemoveEndpointImpl(const QString& endpoint, HttpMethod method);
 
    virtual bool SetCertificateImpl(const QByteArray& certificateData, SslEncoding encoding);
    virtual bool SetPrivateKeyImpl(const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase);
 
+   virtual bool ReloadCertificateImpl(const QByteArray& certificateData, const QByteArray& keyData, SslEncoding encoding, SslKeyAlgorithm algorithm, const QString& passphrase);
+   virtual bool TlsSettingsImpl(const TlsOptions& options);
+   virtual TlsOptions TlsSettingsImpl();
+   virtual bool ConnectionSettingsImpl(const ConnectionOptions& options);
+   virtual ConnectionOptions ConnectionSettingsImpl();
+   virtual bool LoadSheddingImpl(const SheddingOptions& options);
+   virtual SheddingOptions LoadSheddingImpl();
+   virtual bool RateLimitImpl(const RateLimitOptions& options);
+   virtual RateLimitOptions RateLimitImpl();
+   virtual bool ThreadsImpl(int workers, int loops);
+   virtual int WorkersImpl();
+   virtual int LoopsImpl();
+   virtual bool CpuAffinityImpl(const QList<int>& cpus);
+   virtual QList<int> CpuAffinityImpl();
+   virtual bool StreamingWindowImpl(qint64 bytes);
+   virtual qint64 StreamingWindowImpl();
+   virtual bool ResponseCacheSizeImpl(qint64 bytes);
+   virtual qint64 ResponseCacheSizeImpl();
+   virtual void InvalidateCacheImpl(const QString& endpoint);
+   virtual CompressionStatistics CompressionStatsImpl();
+   virtual Metrics MetricsSnapshotImpl();
+   virtual bool AddMetricsEndpointImpl(const QString& endpoint);
+   virtual bool AddEventEndpointImpl(const QString& endpoint, int maxSubscribers);
+   virtual int PublishEventImpl(const QString& endpoint, const QByteArray& data, const QString& event, const QString& id);
+
 protected:
    class HttpServerWebccPrivate;
    std::unique_ptr<HttpServerWebccPrivate> p;   //!< Pointer to implementation of HTTP server with Webcc.
@@ -99,12 +128,24 @@ protected:
    ServerProtocol protocol;
    QHostAddress address;
    int port;
+   QList<ListenEndpoint> listenEndpoints;       //!< Endpoints listened on in addition to #address and #port
 
 private:
+   static void ValidateCpus(const QList<int>& cpus);
+
    mutable QMutex members;                      //!< Mutex for the member variables.
 
    static EventMsg msgInvalidAddressEx;
    static EventMsg msgInvalidPortEx;
+   static EventMsg msgInvalidThreadCountEx;
+   static EventMsg msgInvalidCpuEx;
+   static EventMsg msgInvalidStreamingWindowEx;
+   static EventMsg msgInvalidCacheSizeEx;
+   static EventMsg msgInvalidTlsOptionsEx;
+   static EventMsg msgInvalidConnectionOptionsEx;
+   static EventMsg msgInvalidSheddingOptionsEx;
+   static EventMsg msgInvalidRateLimitOptionsEx;
+   static EventMsg msgInvalidEndpointOptionsEx;
 };
 
 }
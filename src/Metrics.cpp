@@ -0,0 +1,273 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "Metrics.h"
+
+#include <algorithm>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//! Index of the shard of the calling thread, assigned on its first use.
+//*****************************************************************************
+static int ThreadIndex()
+{
+   static std::atomic<int> nextIndex{ 0 };
+   thread_local int index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+   return index;
+}
+
+EndpointCounters::~EndpointCounters()
+{
+   for (std::atomic<Shard*>& shard : shards)
+      delete shard.load(std::memory_order_relaxed);
+}
+
+//*****************************************************************************
+//!
+//! \brief Shard of the calling thread.
+//! With more threads than shards, threads share a shard. The counters are
+//! atomic, so sharing only costs contention.
+//!
+//*****************************************************************************
+EndpointCounters::Shard& EndpointCounters::LocalShard()
+{
+   std::atomic<Shard*>& slot = shards[ThreadIndex() % shardCount];
+   Shard* shard = slot.load(std::memory_order_acquire);
+   if (shard)
+      return *shard;
+
+   Shard* allocated = new Shard();
+   if (slot.compare_exchange_strong(shard, allocated, std::memory_order_acq_rel))
+      return *allocated;
+
+   delete allocated;   // Another thread sharing the slot was first
+   return *shard;
+}
+
+void EndpointCounters::Record(Phase phase, Clock::duration duration)
+{
+   double seconds = std::chrono::duration<double>(duration).count();
+   int bucket = int(std::lower_bound(bounds.begin(), bounds.end(), seconds) - bounds.begin());
+
+   Shard& shard = LocalShard();
+   shard.buckets[phase][bucket].fetch_add(1, std::memory_order_relaxed);
+   shard.nanoseconds[phase].fetch_add(quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()), std::memory_order_relaxed);
+}
+
+void EndpointCounters::Finish(int statusCode, qint64 bytesIn, qint64 bytesOut)
+{
+   Shard& shard = LocalShard();
+   shard.requests.fetch_add(1, std::memory_order_relaxed);
+   shard.bytesIn.fetch_add(quint64(qMax<qint64>(bytesIn, 0)), std::memory_order_relaxed);
+   shard.bytesOut.fetch_add(quint64(qMax<qint64>(bytesOut, 0)), std::memory_order_relaxed);
+   if (statusCode >= 100 && statusCode < 600)
+      shard.statusClasses[statusCode / 100 - 1].fetch_add(1, std::memory_order_relaxed);
+}
+
+void EndpointCounters::Collect(HttpServer::EndpointMetrics& metrics) const
+{
+   HttpServer::LatencyHistogram* histograms[PhaseCount] = { &metrics.routing, &metrics.handler, &metrics.serialization };
+   for (HttpServer::LatencyHistogram* histogram : histograms) {
+      histogram->bounds = QList<double>(bounds.begin(), bounds.end());
+      histogram->counts = QList<quint64>(bucketCount, 0);
+   }
+
+   metrics.inFlight = inFlight.load(std::memory_order_relaxed);
+   metrics.rejected = rejected.load(std::memory_order_relaxed);
+   metrics.coalesced = coalesced.load(std::memory_order_relaxed);
+
+   for (const std::atomic<Shard*>& slot : shards) {
+      const Shard* shard = slot.load(std::memory_order_acquire);
+      if (!shard)
+         continue;
+
+      for (int phase = 0; phase < PhaseCount; phase++) {
+         for (int bucket = 0; bucket < bucketCount; bucket++) {
+            quint64 count = shard->buckets[phase][bucket].load(std::memory_order_relaxed);
+            histograms[phase]->counts[bucket] += count;
+            histograms[phase]->count += count;
+         }
+         histograms[phase]->sum += double(shard->nanoseconds[phase].load(std::memory_order_relaxed)) / 1e9;
+      }
+
+      metrics.requests += shard->requests.load(std::memory_order_relaxed);
+      metrics.bytesIn  += shard->bytesIn.load(std::memory_order_relaxed);
+      metrics.bytesOut += shard->bytesOut.load(std::memory_order_relaxed);
+      for (int i = 0; i < 5; i++)
+         metrics.statusClasses[i] += shard->statusClasses[i].load(std::memory_order_relaxed);
+   }
+}
+
+void ServerCounters::Count(int statusCode)
+{
+   if (statusCode >= 0 && statusCode < 600)
+      statusCodes[statusCode].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ServerCounters::Collect(HttpServer::Metrics& metrics) const
+{
+   metrics.inFlight = inFlight.load(std::memory_order_relaxed);
+   for (int code = 0; code < 600; code++) {
+      quint64 count = statusCodes[code].load(std::memory_order_relaxed);
+      if (count)
+         metrics.statusCodes.insert(code, count);
+   }
+   unmatched.Collect(metrics.unmatched);
+}
+
+//*****************************************************************************
+//!
+//! \brief Formats metrics in the Prometheus text exposition format (0.0.4).
+//!
+//! \param   metrics     The metrics.
+//! \returns QByteArray  The metrics as text.
+//!
+//*****************************************************************************
+QByteArray ServerCounters::Prometheus(const HttpServer::Metrics& metrics)
+{
+   auto escape = [](const QString& value) {
+      QByteArray escaped = value.toUtf8();
+      return escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+   };
+   auto method = [](HttpServer::HttpMethod method) -> QByteArray {
+      #pragma push_macro("DELETE")
+      #undef DELETE
+      switch (method) {
+         case HttpServer::GET:     return "GET";
+         case HttpServer::POST:    return "POST";
+         case HttpServer::PUT:     return "PUT";
+         case HttpServer::DELETE:  return "DELETE";
+         case HttpServer::HEAD:    return "HEAD";
+         case HttpServer::OPTIONS: return "OPTIONS";
+         case HttpServer::PATCH:   return "PATCH";
+         case HttpServer::ALL:     return "ALL";
+         default:                  return "UNKNOWN";
+      }
+      #pragma pop_macro("DELETE")
+   };
+
+   QList<const HttpServer::EndpointMetrics*> endpoints;
+   for (const HttpServer::EndpointMetrics& endpoint : metrics.endpoints)
+      endpoints.append(&endpoint);
+   endpoints.append(&metrics.unmatched);
+
+   QByteArray text;
+   text.reserve(4096 + endpoints.size() * 4096);
+
+   text += "# HELP http_server_in_flight_requests Requests being processed.\n"
+           "# TYPE http_server_in_flight_requests gauge\n"
+           "http_server_in_flight_requests " + QByteArray::number(metrics.inFlight) + '\n';
+
+   text += "# HELP http_server_responses_total Responses by status code.\n"
+           "# TYPE http_server_responses_total counter\n";
+   for (auto i = metrics.statusCodes.cbegin(); i != metrics.statusCodes.cend(); i++)
+      text += "http_server_responses_total{code=\"" + QByteArray::number(i.key()) + "\"} " + QByteArray::number(i.value()) + '\n';
+
+   struct Counter { const char* name; const char* help; quint64 HttpServer::EndpointMetrics::* member; };
+   static const Counter counters[] = {
+      { "http_server_requests_total",         "Requests by endpoint.",                    &HttpServer::EndpointMetrics::requests },
+      { "http_server_request_bytes_total",    "Bytes of request bodies by endpoint.",     &HttpServer::EndpointMetrics::bytesIn  },
+      { "http_server_response_bytes_total",   "Bytes of response bodies by endpoint.",    &HttpServer::EndpointMetrics::bytesOut },
+      { "http_server_rejected_requests_total", "Requests refused by the admission control by endpoint.", &HttpServer::EndpointMetrics::rejected },
+      { "http_server_coalesced_requests_total", "Requests sharing the response of another request by endpoint.", &HttpServer::EndpointMetrics::coalesced }
+   };
+   for (const Counter& counter : counters) {
+      text += QByteArray("# HELP ") + counter.name + ' ' + counter.help + "\n# TYPE " + counter.name + " counter\n";
+      for (const HttpServer::EndpointMetrics* endpoint : endpoints)
+         text += QByteArray(counter.name) + "{endpoint=\"" + escape(endpoint->endpoint) + "\",method=\"" + method(endpoint->method) + "\"} " + QByteArray::number(endpoint->*counter.member) + '\n';
+   }
+
+   struct Phase { const char* name; HttpServer::LatencyHistogram HttpServer::EndpointMetrics::* member; };
+   static const Phase phases[] = {
+      { "routing",       &HttpServer::EndpointMetrics::routing       },
+      { "handler",       &HttpServer::EndpointMetrics::handler       },
+      { "serialization", &HttpServer::EndpointMetrics::serialization }
+   };
+   text += "# HELP http_server_request_duration_seconds Time spent per request phase.\n"
+           "# TYPE http_server_request_duration_seconds histogram\n";
+   for (const HttpServer::EndpointMetrics* endpoint : endpoints) {
+      QByteArray labels = "endpoint=\"" + escape(endpoint->endpoint) + "\",method=\"" + method(endpoint->method) + "\",phase=\"";
+      for (const Phase& phase : phases) {
+         const HttpServer::LatencyHistogram& histogram = endpoint->*phase.member;
+         QByteArray phaseLabels = labels + phase.name + '"';
+         quint64 cumulative = 0;
+         for (qsizetype i = 0; i < histogram.counts.size(); i++) {
+            cumulative += histogram.counts[i];
+            QByteArray bound = i < histogram.bounds.size() ? QByteArray::number(histogram.bounds[i]) : QByteArray("+Inf");
+            text += "http_server_request_duration_seconds_bucket{" + phaseLabels + ",le=\"" + bound + "\"} " + QByteArray::number(cumulative) + '\n';
+         }
+         text += "http_server_request_duration_seconds_sum{" + phaseLabels + "} " + QByteArray::number(histogram.sum, 'g', 9) + '\n';
+         text += "http_server_request_duration_seconds_count{" + phaseLabels + "} " + QByteArray::number(histogram.count) + '\n';
+      }
+   }
+
+   text += "# HELP http_server_compressed_bytes_total Bytes of compressed response bodies before and after compression.\n"
+           "# TYPE http_server_compressed_bytes_total counter\n"
+           "http_server_compressed_bytes_total{stage=\"in\"} " + QByteArray::number(metrics.compression.bytesIn) + '\n' +
+           "http_server_compressed_bytes_total{stage=\"out\"} " + QByteArray::number(metrics.compression.bytesOut) + '\n';
+   text += "# HELP http_server_compression_wall_seconds_total Wall-clock time spent compressing response bodies.\n"
+           "# TYPE http_server_compression_wall_seconds_total counter\n"
+           "http_server_compression_wall_seconds_total " + QByteArray::number(double(metrics.compression.wallNanoseconds) / 1e9, 'g', 9) + '\n';
+
+   text += "# HELP http_server_tls_handshakes_total TLS handshakes by kind.\n"
+           "# TYPE http_server_tls_handshakes_total counter\n"
+           "http_server_tls_handshakes_total{kind=\"full\"} " + QByteArray::number(metrics.tls.fullHandshakes) + '\n' +
+           "http_server_tls_handshakes_total{kind=\"resumed\"} " + QByteArray::number(metrics.tls.resumedHandshakes) + '\n';
+   text += "# HELP http_server_tls_ticket_key_rotations_total Rotations of the session ticket key.\n"
+           "# TYPE http_server_tls_ticket_key_rotations_total counter\n"
+           "http_server_tls_ticket_key_rotations_total " + QByteArray::number(metrics.tls.ticketKeyRotations) + '\n';
+
+   text += "# HELP http_server_connections Open HTTPS connections by state.\n"
+           "# TYPE http_server_connections gauge\n"
+           "http_server_connections{state=\"open\"} " + QByteArray::number(metrics.connections.open) + '\n' +
+           "http_server_connections{state=\"idle\"} " + QByteArray::number(metrics.connections.idle) + '\n';
+   text += "# HELP http_server_connections_refused_total HTTPS connections refused at the handshake.\n"
+           "# TYPE http_server_connections_refused_total counter\n"
+           "http_server_connections_refused_total " + QByteArray::number(metrics.connections.refused) + '\n';
+
+   text += "# HELP http_server_cpu_load CPU time of the process per core in the last sample.\n"
+           "# TYPE http_server_cpu_load gauge\n"
+           "http_server_cpu_load " + QByteArray::number(metrics.shedding.cpuLoad, 'g', 6) + '\n';
+   text += "# HELP http_server_overloaded Whether requests are shed.\n"
+           "# TYPE http_server_overloaded gauge\n"
+           "http_server_overloaded " + QByteArray(metrics.shedding.overloaded ? "1" : "0") + '\n';
+   text += "# HELP http_server_shed_requests_total Requests refused because the server was overloaded.\n"
+           "# TYPE http_server_shed_requests_total counter\n"
+           "http_server_shed_requests_total " + QByteArray::number(metrics.shedding.shed) + '\n';
+
+   text += "# HELP http_server_rate_limited_requests_total Requests refused by the rate limit.\n"
+           "# TYPE http_server_rate_limited_requests_total counter\n"
+           "http_server_rate_limited_requests_total " + QByteArray::number(metrics.rateLimited) + '\n';
+
+   text += "# HELP http_server_logged_events_total Logged warnings and errors.\n"
+           "# TYPE http_server_logged_events_total counter\n"
+           "http_server_logged_events_total{severity=\"warning\"} " + QByteArray::number(metrics.loggedWarnings) + '\n' +
+           "http_server_logged_events_total{severity=\"error\"} " + QByteArray::number(metrics.loggedErrors) + '\n';
+
+   return text;
+}
+
+}
@@ -0,0 +1,155 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_METRICS__H
+#define MAU_METRICS__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#pragma pop_macro("new")
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Request counters and latency histograms of an endpoint.
+//!
+//! Every thread records into a shard of its own, so recording is lock-free
+//! and threads don't contend for cache lines. A snapshot sums up the shards.
+//! Shards are allocated on the first request of a thread.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class EndpointCounters
+{
+public:
+   enum Phase {
+      Routing,                                     //!< Lookup of the route
+      Handler,                                     //!< The callback, or serving the file
+      Serialization,                               //!< Compression and conversion of the response
+      PhaseCount
+   };
+
+   typedef std::chrono::steady_clock Clock;
+
+   static constexpr std::array<double, 16> bounds = {
+      0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+      0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+   };                                              //!< Upper bounds of the histogram buckets in seconds, an overflow bucket follows
+
+   EndpointCounters() = default;
+   EndpointCounters(const EndpointCounters&) = delete;
+   EndpointCounters& operator=(const EndpointCounters&) = delete;
+   ~EndpointCounters();
+
+   void Record(Phase phase, Clock::duration duration);
+      //!< \brief Adds a duration to the histogram of #phase.
+
+   void Finish(int statusCode, qint64 bytesIn, qint64 bytesOut);
+      //!< \brief Counts a finished request.
+
+   void Collect(HttpServer::EndpointMetrics& metrics) const;
+      //!< \brief Sums up the shards into #metrics.
+
+   std::atomic<qint64> inFlight{ 0 };            //!< Requests being processed, see InFlightGuard
+   std::atomic<quint64> rejected{ 0 };           //!< Requests refused by the admission control
+   std::atomic<quint64> coalesced{ 0 };          //!< Requests sharing the response of another request
+
+private:
+   static constexpr int shardCount = 16;
+   static constexpr int bucketCount = int(bounds.size()) + 1;
+
+   struct alignas(64) Shard {
+      std::atomic<quint64> buckets[PhaseCount][bucketCount] = {};
+      std::atomic<quint64> nanoseconds[PhaseCount] = {};
+      std::atomic<quint64> requests{ 0 };
+      std::atomic<quint64> bytesIn{ 0 };
+      std::atomic<quint64> bytesOut{ 0 };
+      std::atomic<quint64> statusClasses[5] = {};
+   };
+
+   Shard& LocalShard();
+
+   std::atomic<Shard*> shards[shardCount] = {};
+};
+
+//****************************************************************************
+//!
+//! \brief Request counters of a server.
+//!
+//****************************************************************************
+
+class ServerCounters
+{
+public:
+   void Count(int statusCode);
+      //!< \brief Counts a response with #statusCode.
+
+   void Collect(HttpServer::Metrics& metrics) const;
+      //!< \brief Copies the server wide counters into #metrics.
+
+   EndpointCounters unmatched;                    //!< Requests without a route, answered with 404 or 405
+   std::atomic<qint64> inFlight{ 0 };            //!< Requests being processed, see InFlightGuard
+
+   static QByteArray Prometheus(const HttpServer::Metrics& metrics);
+      //!< \brief Formats #metrics in the Prometheus text exposition format.
+
+private:
+   std::atomic<quint64> statusCodes[600] = {};
+};
+
+//****************************************************************************
+//!
+//! \brief Counts a request as in flight for the lifetime of the guard.
+//!
+//! The count is released on every path out of the request, including
+//! exceptions.
+//!
+//****************************************************************************
+
+class InFlightGuard
+{
+public:
+   explicit InFlightGuard(std::atomic<qint64>& inFlight) : inFlight(inFlight) { inFlight.fetch_add(1, std::memory_order_relaxed); }
+   ~InFlightGuard() { inFlight.fetch_sub(1, std::memory_order_relaxed); }
+   InFlightGuard(const InFlightGuard&) = delete;
+   InFlightGuard& operator=(const InFlightGuard&) = delete;
+
+private:
+   std::atomic<qint64>& inFlight;
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "RateLimiter.h"
+
+#include <cmath>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+void RateLimiter::Options(const HttpServer::RateLimitOptions& options)
+{
+   RateLimiter::options = options;
+   for (Shard& shard : shards) {
+      shard.buckets.clear();
+      shard.used.clear();
+   }
+}
+
+//*****************************************************************************
+//!
+//! \brief Takes a token from the bucket of a key.
+//! A new key starts with a full bucket. The bucket is refilled for the time
+//! since it was used last, up to #burst tokens.
+//!
+//! \param   key         The key of the request.
+//! \param   retryAfter  Set to the seconds until a token is available if the
+//!                      request is refused.
+//! \returns bool        If the request may be processed.
+//!
+//*****************************************************************************
+bool RateLimiter::Allow(std::string_view key, int& retryAfter)
+{
+   const double burst = qMax(options.burst, 1.0);
+   QByteArray bucketKey = QByteArray::fromRawData(key.data(), qsizetype(key.size()));
+   Shard& shard = shards[qHash(bucketKey) % shardCount];
+   Clock::time_point now = Clock::now();
+
+   QMutexLocker lock(&shard.mutex);
+   auto bucket = shard.buckets.find(bucketKey);
+   if (bucket == shard.buckets.end()) {
+      if (shard.buckets.size() >= maxBucketsPerShard)
+         Evict(shard);
+      QByteArray ownKey(key.data(), qsizetype(key.size()));
+      shard.used.push_front(ownKey);
+      bucket = shard.buckets.insert(ownKey, Bucket{ burst, now, shard.used.begin() });
+   } else {
+      double elapsed = std::chrono::duration<double>(now - bucket->updated).count();
+      bucket->tokens = qMin(burst, bucket->tokens + elapsed * options.rate);
+      bucket->updated = now;
+      shard.used.splice(shard.used.begin(), shard.used, bucket->use);
+   }
+
+   if (bucket->tokens >= 1.0) {
+      bucket->tokens -= 1.0;
+      return true;
+   }
+
+   retryAfter = qMax(1, int(std::ceil((1.0 - bucket->tokens) / options.rate)));
+   lock.unlock();
+   rejected.fetch_add(1, std::memory_order_relaxed);
+   return false;
+}
+
+//*****************************************************************************
+//!
+//! \brief The client in a list of forwarding addresses.
+//! Every proxy appends the address it received the request from, so the last
+//! entry was written by the proxy in front of the server. Entries before the
+//! ones of the trusted proxies come from the client and can be anything.
+//!
+//! \param   forwarded         Value of the client header.
+//! \param   trustedProxies    Proxies in front of the server.
+//! \returns std::string_view  The client, empty if the header is.
+//!
+//*****************************************************************************
+std::string_view RateLimiter::Client(std::string_view forwarded, int trustedProxies)
+{
+   std::string_view client = forwarded;
+   for (int entry = 0; entry < trustedProxies; entry++) {
+      std::string_view::size_type separator = forwarded.rfind(',');
+      client = separator == std::string_view::npos ? forwarded : forwarded.substr(separator + 1);
+      if (separator == std::string_view::npos)
+         break;
+      forwarded = forwarded.substr(0, separator);
+   }
+
+   while (!client.empty() && client.front() == ' ')
+      client.remove_prefix(1);
+   while (!client.empty() && client.back() == ' ')
+      client.remove_suffix(1);
+   return client;
+}
+
+//*****************************************************************************
+//! Drops the bucket used least recently. A client that comes back gets a
+//! full bucket, which is at most #burst requests more than it had left.
+//*****************************************************************************
+void RateLimiter::Evict(Shard& shard)
+{
+   if (shard.used.empty())
+      return;
+
+   shard.buckets.remove(shard.used.back());
+   shard.used.pop_back();
+}
+
+}
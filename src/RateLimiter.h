@@ -0,0 +1,117 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_RATELIMITER__H
+#define MAU_RATELIMITER__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <string_view>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Token buckets limiting the request rate per key.
+//!
+//! Every key has a bucket holding up to #burst tokens, refilled at #rate
+//! tokens per second. A request takes a token or is refused. The buckets
+//! are spread over shards by the hash of their key, each with a lock of its
+//! own, so requests of different clients rarely contend. A shard keeps its
+//! keys in order of use and drops the bucket used least recently when it
+//! reaches its size limit.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class RateLimiter
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   RateLimiter() = default;
+   RateLimiter(const RateLimiter&) = delete;
+   RateLimiter& operator=(const RateLimiter&) = delete;
+
+   void Options(const HttpServer::RateLimitOptions& options);
+      //!< \brief Sets the rate and drops all buckets. Not thread-safe, set it while the server is stopped.
+   HttpServer::RateLimitOptions Options() const { return options; }
+
+   bool Enabled() const { return options.rate > 0; }
+
+   bool Allow(std::string_view key, int& retryAfter);
+      //!< \brief Takes a token from the bucket of #key.
+      //!< \param key        The key of the request.
+      //!< \param retryAfter Set to the seconds until a token is available if the request is refused.
+      //!< \return If the request may be processed.
+
+   static std::string_view Client(std::string_view forwarded, int trustedProxies);
+      //!< \brief The client in a comma-separated list of forwarding addresses.
+      //!< \param forwarded      Value of the client header, e.g. X-Forwarded-For.
+      //!< \param trustedProxies Proxies in front of the server that append to the header.
+      //!< \return The entry #trustedProxies from the end, the first one if there are fewer.
+
+   quint64 Rejected() const { return rejected.load(std::memory_order_relaxed); }
+      //!< \brief Requests refused since the server was created.
+
+private:
+   static constexpr int shardCount = 16;
+   static constexpr int maxBucketsPerShard = 1024;
+
+   typedef std::list<QByteArray> UseOrder;
+
+   struct Bucket {
+      double tokens;
+      Clock::time_point updated;
+      UseOrder::iterator use;                      //!< Position of the key in Shard::used
+   };
+
+   struct alignas(64) Shard {
+      QMutex mutex;
+      QHash<QByteArray, Bucket> buckets;
+      UseOrder used;                               //!< Keys of #buckets, used most recently first
+   };
+
+   static void Evict(Shard& shard);
+
+   HttpServer::RateLimitOptions options;
+   Shard shards[shardCount];
+   std::atomic<quint64> rejected{ 0 };
+};
+
+}
+
+#endif
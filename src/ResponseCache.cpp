@@ -0,0 +1,268 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "ResponseCache.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QCryptographicHash>
+#pragma pop_macro("new")
+
+#include <algorithm>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//! Constructor
+//*****************************************************************************
+ResponseCache::ResponseCache(qint64 maxSize) :
+   cache(maxSize)
+{
+}
+
+//*****************************************************************************
+//!
+//! \brief Builds the cache key of a request.
+//!
+//! \param   path        URL path of the request.
+//! \param   query       Query component of the request.
+//! \returns QByteArray  The key.
+//!
+//*****************************************************************************
+QByteArray ResponseCache::Key(std::string_view path, std::string_view query)
+{
+   QByteArray key;
+   key.reserve(qsizetype(path.size() + query.size() + 1));
+   key.append(path.data(), path.size());
+   key.append('?');
+   key.append(query.data(), query.size());
+   return key;
+}
+
+//*****************************************************************************
+//!
+//! \brief Generates a strong entity tag from the response body.
+//! The tag is a hash of the body, so it stays the same across restarts.
+//!
+//! \param   response    The response.
+//! \returns QByteArray  The quoted entity tag.
+//!
+//*****************************************************************************
+QByteArray ResponseCache::ETag(const HttpServer::HttpResponse& response)
+{
+   QCryptographicHash hash(QCryptographicHash::Sha1);
+   if (response.sharedBody)
+      hash.addData(QByteArrayView(response.sharedBody->data(), response.sharedBody->size()));
+   else
+      hash.addData(response.body);
+
+   return '"' + hash.result().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals) + '"';
+}
+
+//*****************************************************************************
+//!
+//! \brief Checks an If-None-Match header value against an entity tag.
+//! Uses the weak comparison of RFC 7232, 3.2.
+//!
+//! \param   ifNoneMatch Value of the If-None-Match header.
+//! \param   etag        The quoted entity tag of the current response.
+//! \returns bool        If the client's representation is up to date.
+//!
+//*****************************************************************************
+bool ResponseCache::Matches(std::string_view ifNoneMatch, const QByteArray& etag)
+{
+   std::string_view current(etag.constData(), etag.size());
+
+   while (!ifNoneMatch.empty()) {
+      std::string_view::size_type end = ifNoneMatch.find(',');
+      std::string_view tag = ifNoneMatch.substr(0, end);
+      ifNoneMatch = end == std::string_view::npos ? std::string_view() : ifNoneMatch.substr(end + 1);
+
+      while (!tag.empty() && tag.front() == ' ')
+         tag.remove_prefix(1);
+      while (!tag.empty() && tag.back() == ' ')
+         tag.remove_suffix(1);
+      if (tag.substr(0, 2) == "W/")
+         tag.remove_prefix(2);
+
+      if (tag == "*" || tag == current)
+         return true;
+   }
+   return false;
+}
+
+//*****************************************************************************
+//!
+//! \brief Checks if a request carries credentials.
+//! Requests with credentials get responses for their user, they are neither
+//! answered from a shared response nor is their response shared, unless the
+//! header is part of the key.
+//!
+//! \param   request       The request.
+//! \param   keyedHeaders  Headers whose values are part of the key.
+//! \returns bool          If the request has credentials not in the key.
+//!
+//*****************************************************************************
+bool ResponseCache::CarriesCredentials(const HttpServer::HttpRequestView& request, const QList<QByteArray>& keyedHeaders)
+{
+   for (const char* credentials : { "Authorization", "Cookie" }) {
+      bool found = false;
+      request.Header(credentials, &found);
+      bool keyed = std::any_of(keyedHeaders.begin(), keyedHeaders.end(), [&](const QByteArray& header) { return header.compare(credentials, Qt::CaseInsensitive) == 0; });
+      if (found && !keyed)
+         return true;
+   }
+   return false;
+}
+
+//*****************************************************************************
+//!
+//! \brief Checks if a response may be kept for other clients (RFC 9111, 3).
+//! Cached responses are served without revalidation and compressed by the
+//! cache itself, so only Vary: Accept-Encoding is supported.
+//!
+//! \param   response  The response.
+//! \returns bool      If the response may be cached.
+//!
+//*****************************************************************************
+bool ResponseCache::Storable(const HttpServer::HttpResponse& response)
+{
+   for (auto header = response.headers.cbegin(); header != response.headers.cend(); header++) {
+      if (header.key().compare("Set-Cookie", Qt::CaseInsensitive) == 0)
+         return false;
+
+      bool cacheControl = header.key().compare("Cache-Control", Qt::CaseInsensitive) == 0;
+      bool vary = header.key().compare("Vary", Qt::CaseInsensitive) == 0;
+      if (!cacheControl && !vary)
+         continue;
+
+      for (const QString& part : header.value().split(',')) {
+         QString directive = part.section('=', 0, 0).trimmed().toLower();
+         if (cacheControl && (directive == "private" || directive == "no-store" || directive == "no-cache"))
+            return false;
+         if (vary && !directive.isEmpty() && directive != "accept-encoding")
+            return false;
+      }
+   }
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Looks up a fresh entry.
+//!
+//! \param   key   Cache key of the request.
+//! \returns Entry The entry, or null if there is no fresh entry.
+//!
+//*****************************************************************************
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::Find(const QByteArray& key)
+{
+   QMutexLocker lock(&mutex);
+   std::shared_ptr<const Entry>* entry = cache.object(key);
+   if (!entry)
+      return nullptr;
+
+   if ((*entry)->expiry.hasExpired()) {
+      cache.remove(key);
+      return nullptr;
+   }
+   return *entry;
+}
+
+void ResponseCache::Insert(const QByteArray& key, std::shared_ptr<const Entry> entry)
+{
+   qsizetype cost = Cost(*entry);
+
+   QMutexLocker lock(&mutex);
+   cache.insert(key, new std::shared_ptr<const Entry>(std::move(entry)), cost);
+}
+
+void ResponseCache::Update(const QByteArray& key, const std::shared_ptr<const Entry>& entry)
+{
+   qsizetype cost = Cost(*entry);
+
+   QMutexLocker lock(&mutex);
+   std::shared_ptr<const Entry>* cached = cache.object(key);
+   if (cached && *cached == entry)
+      cache.insert(key, new std::shared_ptr<const Entry>(entry), cost);
+}
+
+void ResponseCache::Invalidate(const QString& endpoint)
+{
+   QMutexLocker lock(&mutex);
+   if (endpoint.isNull()) {
+      cache.clear();
+      return;
+   }
+
+   const QList<QByteArray> keys = cache.keys();
+   for (const QByteArray& key : keys) {
+      if ((*cache[key])->endpoint == endpoint)
+         cache.remove(key);
+   }
+}
+
+void ResponseCache::MaxSize(qint64 bytes)
+{
+   QMutexLocker lock(&mutex);
+   cache.setMaxCost(bytes);
+}
+
+qint64 ResponseCache::MaxSize() const
+{
+   QMutexLocker lock(&mutex);
+   return cache.maxCost();
+}
+
+//*****************************************************************************
+//! Approximate memory used by an entry.
+//*****************************************************************************
+qsizetype ResponseCache::Cost(const Entry& entry)
+{
+   qsizetype cost = entry.response.BodySize() + entry.etag.size();
+   for (auto i = entry.response.headers.cbegin(); i != entry.response.headers.cend(); i++)
+      cost += (i.key().size() + i.value().size()) * qsizetype(sizeof(QChar));
+
+   QMutexLocker lock(&entry.variantsMutex);
+   for (const HttpServer::SharedBuffer& variant : entry.variants)
+      cost += qsizetype(variant->size());
+   return cost;
+}
+
+//*****************************************************************************
+//! Compressed variants of a cached body, so it isn't compressed per request.
+//*****************************************************************************
+HttpServer::SharedBuffer ResponseCache::Entry::Variant(const QByteArray& encoding) const
+{
+   QMutexLocker lock(&variantsMutex);
+   return variants.value(encoding);
+}
+
+void ResponseCache::Entry::AddVariant(const QByteArray& encoding, HttpServer::SharedBuffer body) const
+{
+   QMutexLocker lock(&variantsMutex);
+   variants.insert(encoding, std::move(body));
+}
+
+}
@@ -0,0 +1,121 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#ifndef MAU_RESPONSECACHE__H
+#define MAU_RESPONSECACHE__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QDeadlineTimer>
+#pragma pop_macro("new")
+
+#include <memory>
+#include <string_view>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Memory-bounded LRU cache of responses.
+//!
+//! Entries are shared and immutable, so a hit hands out the cached body
+//! without copying it, even if the entry is evicted meanwhile.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class ResponseCache
+{
+public:
+   struct Entry {
+      QString endpoint;                            //!< Endpoint that produced the response
+      HttpServer::HttpResponse response;           //!< The cached response, including its ETag header
+      QByteArray etag;                             //!< Strong entity tag of the response body, quoted
+      QDeadlineTimer expiry;                       //!< When the entry becomes stale
+
+      HttpServer::SharedBuffer Variant(const QByteArray& encoding) const;
+         //!< \brief The body compressed with the content coding #encoding, null if there is none yet.
+      void AddVariant(const QByteArray& encoding, HttpServer::SharedBuffer body) const;
+         //!< \brief Keeps the body compressed with the content coding #encoding.
+
+   private:
+      friend class ResponseCache;
+      mutable QMutex variantsMutex;
+      mutable QHash<QByteArray, HttpServer::SharedBuffer> variants; //!< Compressed bodies by content coding, added on first use
+   };
+
+   explicit ResponseCache(qint64 maxSize);
+
+   static QByteArray Key(std::string_view path, std::string_view query);
+      //!< \brief Builds the cache key of a request. The path includes the path variables.
+
+   static QByteArray ETag(const HttpServer::HttpResponse& response);
+      //!< \brief Generates a strong entity tag from the response body.
+
+   static bool Matches(std::string_view ifNoneMatch, const QByteArray& etag);
+      //!< \brief Checks an If-None-Match header value against #etag.
+
+   static bool CarriesCredentials(const HttpServer::HttpRequestView& request, const QList<QByteArray>& keyedHeaders = QList<QByteArray>());
+      //!< \brief If #request has an Authorization or Cookie header that isn't in #keyedHeaders.
+      //!< The response to such a request may belong to one user only.
+
+   static bool Storable(const HttpServer::HttpResponse& response);
+      //!< \brief If #response may be kept for other clients.
+      //!< False if it sets a cookie, is private, no-store or no-cache, or
+      //!< varies by a request header other than Accept-Encoding.
+
+   std::shared_ptr<const Entry> Find(const QByteArray& key);
+      //!< \brief Looks up a fresh entry. Stale entries are removed.
+
+   void Insert(const QByteArray& key, std::shared_ptr<const Entry> entry);
+      //!< \brief Adds an entry. Least recently used entries are evicted to stay within the size.
+
+   void Update(const QByteArray& key, const std::shared_ptr<const Entry>& entry);
+      //!< \brief Accounts for the variants added to #entry, if it is still cached.
+
+   void Invalidate(const QString& endpoint);
+      //!< \brief Removes all entries of #endpoint, or all entries if #endpoint is null.
+
+   void MaxSize(qint64 bytes);
+   qint64 MaxSize() const;
+
+private:
+   static qsizetype Cost(const Entry& entry);
+
+   mutable QMutex mutex;
+   QCache<QByteArray, std::shared_ptr<const Entry>> cache;
+};
+
+}
+
+#endif
@@ -0,0 +1,354 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "RouteTrie.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QUrl>
+#include <QtCore/QRegularExpression>
+#pragma pop_macro("new")
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+static const QRegularExpression pathVariableExactRx(QRegularExpression::anchoredPattern("\\{(.+)\\}"), QRegularExpression::InvertedGreedinessOption);
+
+//*****************************************************************************
+//! Deep copy of a trie node.
+//*****************************************************************************
+RouteTrie::Node::Node(const Node& other) :
+   literals(other.literals),
+   variable(other.variable ? std::make_unique<Node>(*other.variable) : nullptr),
+   routes(other.routes),
+   multiLevelRoutes(other.multiLevelRoutes)
+{
+}
+
+RouteTrie::Node& RouteTrie::Node::operator=(const Node& other)
+{
+   if (this != &other) {
+      literals = other.literals;
+      variable = other.variable ? std::make_unique<Node>(*other.variable) : nullptr;
+      routes = other.routes;
+      multiLevelRoutes = other.multiLevelRoutes;
+   }
+   return *this;
+}
+
+bool RouteTrie::Node::IsEmpty() const
+{
+   return literals.empty() && !variable && routes.isEmpty() && multiLevelRoutes.isEmpty();
+}
+
+//*****************************************************************************
+//! Constructor
+//*****************************************************************************
+RouteTrie::RouteTrie()
+{
+}
+
+//*****************************************************************************
+//!
+//! \brief Splits an endpoint into its path segments.
+//! The endpoint is escaped the same way as the URL path of a request, so the
+//! literal segments can be compared byte by byte.
+//!
+//! \param   endpoint   Endpoint to split.
+//! \returns QList      Segments of the escaped endpoint.
+//!
+//*****************************************************************************
+QList<QString> RouteTrie::Segments(const QString& endpoint)
+{
+   QUrl endpointUrl;
+   endpointUrl.setPath(endpoint);
+   return endpointUrl.path().split("/");
+}
+
+//*****************************************************************************
+//!
+//! \brief Adds a route to the trie.
+//! The variable names are not part of the path shape, so '/a/{x}' and
+//! '/a/{y}' end at the same node and are reported as ambiguous.
+//!
+//! \param   endpoint   Endpoint to add. Has to be validated by the caller.
+//! \param   method     HTTP request method for the endpoint.
+//! \param   options    Options of the endpoint.
+//! \param   kind       How the route is answered.
+//! \param   directory  Directory of a Route::FileRoute, empty otherwise.
+//! \returns QString    The conflicting endpoint or a null string.
+//!
+//*****************************************************************************
+QString RouteTrie::Insert(const QString& endpoint, HttpServer::HttpMethod method, const HttpServer::EndpointOptions& options, Route::Kind kind, const QString& directory)
+{
+   QList<QString> segments = Segments(endpoint);
+   Route route{ endpoint, method, QStringList(), QList<QByteArray>(), options, kind, directory, std::make_shared<EndpointCounters>() };
+   if (options.maxConcurrent > 0)
+      route.admission = std::make_shared<AdmissionGate>(options.maxConcurrent, options.maxQueued, options.queueTimeout);
+
+   Node* node = &root;
+   for (const QString& segment : segments) {
+      if (segment == "#") {   // '#' is at the end, checked in HttpServerWebcc::HttpServerWebccPrivate::AddEndpoint()
+         for (const Route& existing : node->multiLevelRoutes) {
+            if (existing.method == method)
+               return existing.endpoint;
+         }
+         node->multiLevelRoutes.append(route);
+         count++;
+         return QString();
+      }
+
+      QRegularExpressionMatch pathVariableMatch = pathVariableExactRx.match(segment);
+      if (pathVariableMatch.hasMatch()) {
+         route.variableNames.append(pathVariableMatch.captured(1));
+         route.variableKeys.append(pathVariableMatch.captured(1).toUtf8());
+         if (!node->variable)
+            node->variable = std::make_unique<Node>();
+         node = node->variable.get();
+      } else {
+         node = &node->literals[segment.toStdString()];
+      }
+   }
+
+   for (const Route& existing : node->routes) {
+      if (existing.method == method)
+         return existing.endpoint;
+   }
+   node->routes.append(route);
+   count++;
+   return QString();
+}
+
+//*****************************************************************************
+//!
+//! \brief Removes a route from the trie.
+//! Nodes that no longer lead to any route are pruned.
+//!
+//! \param   endpoint   Endpoint to remove, exactly as it was registered.
+//! \param   method     HTTP request method for the endpoint.
+//! \returns bool       If the route was removed.
+//!
+//*****************************************************************************
+bool RouteTrie::Remove(const QString& endpoint, HttpServer::HttpMethod method)
+{
+   if (!Remove(root, Segments(endpoint), 0, endpoint, method))
+      return false;
+
+   count--;
+   return true;
+}
+
+bool RouteTrie::Remove(Node& node, const QList<QString>& segments, qsizetype index, const QString& endpoint, HttpServer::HttpMethod method)
+{
+   auto removeFrom = [&](QList<Route>& routes) {
+      for (qsizetype i = 0; i < routes.size(); i++) {
+         if (routes[i].endpoint == endpoint && routes[i].method == method) {
+            routes.removeAt(i);
+            return true;
+         }
+      }
+      return false;
+   };
+
+   if (index == segments.size())
+      return removeFrom(node.routes);
+
+   const QString& segment = segments[index];
+   if (segment == "#")
+      return removeFrom(node.multiLevelRoutes);
+
+   if (pathVariableExactRx.match(segment).hasMatch()) {
+      if (!node.variable || !Remove(*node.variable, segments, index + 1, endpoint, method))
+         return false;
+      if (node.variable->IsEmpty())
+         node.variable.reset();
+      return true;
+   }
+
+   auto literal = node.literals.find(segment.toStdString());
+   if (literal == node.literals.end() || !Remove(literal->second, segments, index + 1, endpoint, method))
+      return false;
+   if (literal->second.IsEmpty())
+      node.literals.erase(literal);
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Looks up the route for a request.
+//! The same specificity rules as for the former linear scan apply: per method
+//! the match with the lowest level wins, literal segments win over path
+//! variables and a '#' match has a level one higher than the number of
+//! levels it covers. The request method is matched before HttpServer::ALL.
+//!
+//! \param   path     URL path of the request.
+//! \param   method   HTTP request method of the request.
+//! \param   match    Set to the found match.
+//! \returns Lookup   Result of the lookup.
+//!
+//*****************************************************************************
+RouteTrie::Lookup RouteTrie::Find(std::string_view path, HttpServer::HttpMethod method, Match& match) const
+{
+   QVarLengthArray<std::string_view, 16> segments;
+   for (std::string_view::size_type start = 0;;) {
+      std::string_view::size_type end = path.find('/', start);
+      if (end == std::string_view::npos) {
+         segments.append(path.substr(start));
+         break;
+      }
+      segments.append(path.substr(start, end - start));
+      start = end + 1;
+   }
+
+   Candidates candidates;
+   candidates.method = method;
+   Match current;
+   Collect(root, path, segments, 0, current, candidates);
+
+   if (candidates.exact.route) {
+      match = candidates.exact;
+      return Found;
+   } else if (candidates.all.route) {
+      match = candidates.all;
+      return Found;
+   }
+
+   return candidates.any ? MethodNotAllowed : NotFound;
+}
+
+//*****************************************************************************
+//!
+//! \brief Walks the trie along the path segments and collects the routes.
+//! Literal children are visited before the path variable child, so on equal
+//! levels the route with more literal segments is kept.
+//!
+//*****************************************************************************
+void RouteTrie::Collect(const Node& node, std::string_view path, const QVarLengthArray<std::string_view, 16>& segments, qsizetype index, Match& current, Candidates& candidates) const
+{
+   qsizetype remaining = segments.size() - index;
+
+   if (remaining > 0 && !node.multiLevelRoutes.isEmpty()) {
+      Match multiLevel = current;
+      multiLevel.level = int(remaining) + 1;  // One higher than the level a path covered by '#' would have, if it had a path variable per level
+      std::string_view::size_type offset = segments[index].data() - path.data();
+      multiLevel.multiLevel = path.substr(offset > 0 ? offset - 1 : 0); // Add leading '/'
+
+      for (const Route& route : node.multiLevelRoutes) {
+         candidates.any = true;
+         if (route.method == candidates.method)
+            Offer(route, multiLevel, candidates.exact);
+         else if (route.method == HttpServer::ALL)
+            Offer(route, multiLevel, candidates.all);
+      }
+   }
+
+   if (remaining == 0) {
+      for (const Route& route : node.routes) {
+         candidates.any = true;
+         if (route.method == candidates.method)
+            Offer(route, current, candidates.exact);
+         else if (route.method == HttpServer::ALL)
+            Offer(route, current, candidates.all);
+      }
+      return;
+   }
+
+   auto literal = node.literals.find(segments[index]);
+   if (literal != node.literals.end())
+      Collect(literal->second, path, segments, index + 1, current, candidates);
+
+   if (node.variable) {
+      current.variables.append(segments[index]);
+      current.level++;
+      Collect(*node.variable, path, segments, index + 1, current, candidates);
+      current.level--;
+      current.variables.removeLast();
+   }
+}
+
+//*****************************************************************************
+//! Keeps #current as #best if it is more specific.
+//*****************************************************************************
+void RouteTrie::Offer(const Route& route, const Match& current, Match& best)
+{
+   if (best.route && best.level <= current.level)
+      return;  // On equal levels the first match is kept.
+
+   best = current;
+   best.route = &route;
+}
+
+//*****************************************************************************
+//! Collects the routes of all nodes.
+//*****************************************************************************
+QList<RouteTrie::Route> RouteTrie::Routes() const
+{
+   QList<Route> routes;
+   Collect(root, routes);
+   return routes;
+}
+
+void RouteTrie::Collect(const Node& node, QList<Route>& routes)
+{
+   routes.append(node.routes);
+   routes.append(node.multiLevelRoutes);
+   for (const auto& literal : node.literals)
+      Collect(literal.second, routes);
+   if (node.variable)
+      Collect(*node.variable, routes);
+}
+
+//*****************************************************************************
+//!
+//! \brief Builds a regular expression matching the same URL paths as an endpoint.
+//! Path variables match a single segment, a '#' wildcard at the end matches
+//! all remaining segments.
+//!
+//! \param   endpoint   Endpoint to convert.
+//! \returns QString    ECMAScript regular expression.
+//!
+//*****************************************************************************
+QString RouteTrie::Pattern(const QString& endpoint)
+{
+   static const QString specialCharacters("\\^$.|?*+()[]{}");
+
+   QStringList patterns;
+   for (const QString& segment : Segments(endpoint)) {
+      if (segment == "#") {
+         patterns.append(".*");
+      } else if (pathVariableExactRx.match(segment).hasMatch()) {
+         patterns.append("[^/]*");
+      } else {
+         QString escaped;
+         for (QChar character : segment) {
+            if (specialCharacters.contains(character))
+               escaped += '\\';
+            escaped += character;
+         }
+         patterns.append(escaped);
+      }
+   }
+   return patterns.join("/");
+}
+
+}
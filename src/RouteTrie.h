@@ -0,0 +1,168 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#ifndef MAU_ROUTETRIE__H
+#define MAU_ROUTETRIE__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QVarLengthArray>
+#pragma pop_macro("new")
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+#ifndef      MAU_METRICS__H
+   #include "Metrics.h"
+#endif
+
+#ifndef      MAU_ADMISSION__H
+   #include "Admission.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Precompiled segment trie of the registered endpoints.
+//!
+//! Endpoints are split into their path segments once when they are inserted.
+//! Every segment becomes a literal, a path variable ({<name>}) or a multi
+//! level wildcard (#) node, so a lookup only walks the segments of the
+//! requested path and does neither regex nor QUrl work.
+//!
+//! The trie is a value type. Copying it yields an independent deep copy.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class RouteTrie
+{
+public:
+   struct Route {
+      enum Kind {
+         CallbackRoute,                            //!< Answered by HttpServer::OnRequest()
+         FileRoute,                                //!< Answered with a file of #directory
+         MetricsRoute,                             //!< Answered with the metrics of the server
+         EventRoute                                //!< Subscribes to the events of the endpoint
+      };
+
+      QString endpoint;                            //!< The endpoint as it was registered
+      HttpServer::HttpMethod method;               //!< HTTP request method of the route
+      QStringList variableNames;                   //!< Names of the path variables in order of their appearance
+      QList<QByteArray> variableKeys;              //!< UTF-8 encoded #variableNames for lookups without conversion
+      HttpServer::EndpointOptions options;         //!< Options the endpoint was registered with
+      Kind kind;                                   //!< How the route is answered
+      QString directory;                           //!< Directory served by a FileRoute
+      std::shared_ptr<EndpointCounters> counters;  //!< Metrics of the route, kept by the copies of the trie
+      std::shared_ptr<AdmissionGate> admission;    //!< Concurrency limit of the route, null without limit, kept by the copies of the trie
+   };
+
+   struct Match {
+      const Route* route = nullptr;                //!< The matched route, owned by the trie
+      int level = 0;                               //!< The level of the match. The higher the number, the more path variables were used.
+      QVarLengthArray<std::string_view, 8> variables; //!< Values of the path variables, in order of Route::variableNames
+      std::string_view multiLevel;                 //!< Path that matched the multi level '#' wildcard, including the leading '/'
+   };
+
+   enum Lookup {
+      NotFound,                                    //!< No route matches the path
+      MethodNotAllowed,                            //!< Routes match the path, but none for the method
+      Found                                        //!< A route for path and method was found
+   };
+
+   RouteTrie();
+   RouteTrie(const RouteTrie& other) = default;
+   RouteTrie& operator=(const RouteTrie& other) = default;
+
+   QString Insert(const QString& endpoint, HttpServer::HttpMethod method, const HttpServer::EndpointOptions& options = HttpServer::EndpointOptions(), Route::Kind kind = Route::CallbackRoute, const QString& directory = QString());
+      //!< \brief Adds a route for #endpoint and #method.
+      //!< \return The already registered endpoint that routes to the same
+      //!<         paths, or a null string if the route was inserted.
+
+   bool Remove(const QString& endpoint, HttpServer::HttpMethod method);
+      //!< \brief Removes the route that was registered for #endpoint and #method.
+      //!< \return If the route was found and removed.
+
+   Lookup Find(std::string_view path, HttpServer::HttpMethod method, Match& match) const;
+      //!< \brief Looks up the most specific route for #path and #method.
+      //!< Routes registered for HttpServer::ALL are used if there is no
+      //!< route for #method itself.
+      //!< \param path   URL path of the request. #match refers into it.
+      //!< \param method HTTP request method of the request.
+      //!< \param match  Set to the matched route if Found is returned.
+
+   int Count() const { return count; }
+      //!< \brief Number of registered routes.
+
+   QList<Route> Routes() const;
+      //!< \brief All registered routes.
+
+   static QString Pattern(const QString& endpoint);
+      //!< \brief Builds a regular expression (ECMAScript) matching the same URL
+      //!< paths as #endpoint.
+
+private:
+   struct Node {
+      Node() = default;
+      Node(const Node& other);
+      Node& operator=(const Node& other);
+
+      std::map<std::string, Node, std::less<>> literals;   //!< Children for literal segments
+      std::unique_ptr<Node> variable;                      //!< Child for '{name}' segments
+      QList<Route> routes;                                 //!< Routes ending at this node
+      QList<Route> multiLevelRoutes;                       //!< Routes ending with a '#' segment below this node
+
+      bool IsEmpty() const;
+   };
+
+   struct Candidates {
+      HttpServer::HttpMethod method;
+      Match exact;                                 //!< Best match for the requested method
+      Match all;                                   //!< Best match for HttpServer::ALL
+      bool any = false;                            //!< If any route matched the path
+   };
+
+   static QList<QString> Segments(const QString& endpoint);
+   void Collect(const Node& node, std::string_view path, const QVarLengthArray<std::string_view, 16>& segments, qsizetype index, Match& current, Candidates& candidates) const;
+   static void Offer(const Route& route, const Match& current, Match& best);
+   bool Remove(Node& node, const QList<QString>& segments, qsizetype index, const QString& endpoint, HttpServer::HttpMethod method);
+   static void Collect(const Node& node, QList<Route>& routes);
+
+   Node root;
+   int count = 0;
+};
+
+}
+
+#endif
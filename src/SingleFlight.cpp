@@ -0,0 +1,101 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "SingleFlight.h"
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//!
+//! \brief Calls the handler once for all concurrent requests with a key.
+//! A request whose flight failed starts a new one unless another waiting
+//! request did so first, then it waits for that one.
+//!
+//! \param   key       Identity of the request.
+//! \param   handler   Produces the response.
+//! \param   timeout   Milliseconds to wait for the calls of other requests.
+//! \param   response  Set to the response.
+//! \param   shared    Set if #response was produced for another request.
+//! \returns bool      If a response was produced.
+//!
+//*****************************************************************************
+bool SingleFlight::Run(const QByteArray& key, const Handler& handler, int timeout, HttpServer::HttpResponse& response, bool& shared)
+{
+   shared = false;
+   QDeadlineTimer deadline(timeout);
+
+   QMutexLocker lock(&mutex);
+   std::shared_ptr<Flight> flight;
+   while ((flight = flights.value(key))) {
+      while (!flight->done) {
+         if (!flight->finished.wait(&mutex, deadline))
+            return false;
+      }
+
+      if (flight->completed && !flight->streamed) {
+         response = flight->response;   // Shares the body, see HttpResponse::body
+         shared = true;
+         return true;
+      }
+
+      if (flight->completed) {   // A stream can only be sent once
+         lock.unlock();
+         return handler(response);
+      }
+   }
+
+   flight = std::make_shared<Flight>();
+   flights.insert(key, flight);
+   lock.unlock();
+
+   bool completed = false;
+   try {
+      completed = handler(response);
+   }
+   catch (...) {
+      Finish(key, flight, false, nullptr);
+      throw;
+   }
+
+   Finish(key, flight, completed, &response);
+   return completed;
+}
+
+//*****************************************************************************
+//! Hands the response to the waiting requests and ends the flight.
+//*****************************************************************************
+void SingleFlight::Finish(const QByteArray& key, const std::shared_ptr<Flight>& flight, bool completed, const HttpServer::HttpResponse* response)
+{
+   QMutexLocker lock(&mutex);
+   flight->completed = completed;
+   flight->streamed = completed && response->IsStreamed();
+   if (completed && !flight->streamed)
+      flight->response = *response;
+   flight->done = true;
+   flights.remove(key);
+   flight->finished.wakeAll();
+}
+
+}
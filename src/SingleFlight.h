@@ -0,0 +1,99 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_SINGLEFLIGHT__H
+#define MAU_SINGLEFLIGHT__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QByteArray>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#pragma pop_macro("new")
+
+#include <functional>
+#include <memory>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief Coalesces concurrent identical requests into one callback.
+//!
+//! The first request for a key calls the handler, requests with the same key
+//! arriving meanwhile wait for it and get a copy of its response. The body
+//! of the response is implicitly shared, so all of them send the same
+//! buffer. Once the handler returned, the next request calls it again. If
+//! the handler fails, one waiting request calls it next while the others
+//! keep waiting, so a failing backend isn't hit by all of them at once.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class SingleFlight
+{
+public:
+   typedef std::function<bool(HttpServer::HttpResponse& response)> Handler;
+      //!< \brief Produces the response, returns false if it couldn't.
+
+   SingleFlight() = default;
+   SingleFlight(const SingleFlight&) = delete;
+   SingleFlight& operator=(const SingleFlight&) = delete;
+
+   bool Run(const QByteArray& key, const Handler& handler, int timeout, HttpServer::HttpResponse& response, bool& shared);
+      //!< \brief Calls #handler, or waits for the call in flight for #key.
+      //!< A streamed response can't be shared, the waiting requests then call
+      //!< #handler themselves. If the call in flight failed, one of them
+      //!< takes over the flight.
+      //!< \param key      Identity of the request.
+      //!< \param handler  Produces the response.
+      //!< \param timeout  Milliseconds a request waits for the calls of others.
+      //!< \param response Set to the response.
+      //!< \param shared   Set if #response is the one of another request.
+      //!< \return The result of #handler, false if the wait timed out.
+
+private:
+   struct Flight {
+      QWaitCondition finished;
+      bool done = false;
+      bool completed = false;                      //!< The handler produced a response
+      bool streamed = false;                       //!< The response can't be shared
+      HttpServer::HttpResponse response;
+   };
+
+   void Finish(const QByteArray& key, const std::shared_ptr<Flight>& flight, bool completed, const HttpServer::HttpResponse* response);
+
+   QMutex mutex;
+   QHash<QByteArray, std::shared_ptr<Flight>> flights;   //!< Calls in flight by key
+};
+
+}
+
+#endif
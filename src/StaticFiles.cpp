@@ -0,0 +1,184 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "StaticFiles.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QLocale>
+#include <QtCore/QTimeZone>
+#include <QtCore/QMimeDatabase>
+#include <QtCore/QUrl>
+#pragma pop_macro("new")
+
+#include <charconv>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+static const QString httpDateFormat("ddd, dd MMM yyyy hh:mm:ss 'GMT'");   // IMF-fixdate, RFC 9110 5.6.7
+
+//*****************************************************************************
+//! Constructor
+//*****************************************************************************
+StaticFiles::StaticFiles(int metadataTtl, int maxEntries) :
+   cache(maxEntries),
+   metadataTtl(metadataTtl)
+{
+}
+
+//*****************************************************************************
+//!
+//! \brief Metadata of a file.
+//! Missing files are cached as well, so requests for them don't hit the file
+//! system either.
+//!
+//! \param   path     Absolute path of the file.
+//! \returns FileInfo The metadata.
+//!
+//*****************************************************************************
+std::shared_ptr<const StaticFiles::FileInfo> StaticFiles::Info(const QString& path)
+{
+   {
+      QMutexLocker lock(&mutex);
+      std::shared_ptr<const FileInfo>* cached = cache.object(path);
+      if (cached && !(*cached)->expiry.hasExpired())
+         return *cached;
+   }
+
+   static const QMimeDatabase mimeDatabase;
+
+   auto info = std::make_shared<FileInfo>();
+   QFileInfo fileInfo(path);
+   info->path = path;
+   info->directory = fileInfo.isDir();
+   info->exists = fileInfo.isFile() && fileInfo.isReadable();
+   if (info->exists) {
+      QDateTime lastModified = fileInfo.lastModified().toUTC();
+      info->size = fileInfo.size();
+      info->lastModified = lastModified.addMSecs(-lastModified.time().msec());
+      info->lastModifiedHttp = HttpDate(info->lastModified);
+      info->etag = '"' + QByteArray::number(lastModified.toMSecsSinceEpoch(), 16) + '-' + QByteArray::number(info->size, 16) + '"';
+      info->contentType = mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension).name().toUtf8();
+   }
+   info->expiry = QDeadlineTimer(metadataTtl);
+
+   QMutexLocker lock(&mutex);
+   cache.insert(path, new std::shared_ptr<const FileInfo>(info));
+   return info;
+}
+
+//*****************************************************************************
+//! Drops the cached metadata of a file that changed and reads it again.
+//*****************************************************************************
+std::shared_ptr<const StaticFiles::FileInfo> StaticFiles::Refresh(const QString& path)
+{
+   {
+      QMutexLocker lock(&mutex);
+      cache.remove(path);
+   }
+   return Info(path);
+}
+
+//*****************************************************************************
+//!
+//! \brief Resolves a request path below a directory.
+//!
+//! \param   directory    Canonical path of the directory.
+//! \param   relativePath Percent-encoded path below the directory.
+//! \returns QString      Absolute path, null if it leaves the directory.
+//!
+//*****************************************************************************
+QString StaticFiles::Resolve(const QString& directory, std::string_view relativePath)
+{
+   QString relative = QUrl::fromPercentEncoding(QByteArray(relativePath.data(), qsizetype(relativePath.size())));
+   if (relative.contains(QChar(0)) || relative.contains('\\'))
+      return QString();
+
+   QString path = QDir::cleanPath(directory + '/' + relative);
+   if (path != directory && !path.startsWith(directory + '/'))
+      return QString();   // '..' segments leaving the directory
+
+   return path;
+}
+
+//*****************************************************************************
+//!
+//! \brief Parses a Range header value.
+//! Only single byte ranges are supported. Multiple ranges are ignored, so the
+//! whole file is sent, as RFC 9110, 14.2 allows.
+//!
+//! \param   range  Value of the Range header.
+//! \param   size   Size of the file.
+//! \param   first  Set to the first byte of the range.
+//! \param   last   Set to the last byte of the range.
+//! \returns bool   If the range is satisfiable.
+//!
+//*****************************************************************************
+bool StaticFiles::ParseRange(std::string_view range, qint64 size, qint64& first, qint64& last)
+{
+   range.remove_prefix(6);   // "bytes=", checked by the caller
+   std::string_view::size_type dash = range.find('-');
+   if (dash == std::string_view::npos)
+      return false;
+
+   auto parse = [](std::string_view number, qint64& value) {
+      auto result = std::from_chars(number.data(), number.data() + number.size(), value);
+      return !number.empty() && result.ec == std::errc() && result.ptr == number.data() + number.size();
+   };
+
+   std::string_view from = range.substr(0, dash);
+   std::string_view to = range.substr(dash + 1);
+
+   if (from.empty()) {   // Suffix range: the last n bytes
+      qint64 suffix = 0;
+      if (!parse(to, suffix) || suffix == 0 || size == 0)
+         return false;
+      first = qMax<qint64>(size - suffix, 0);
+      last = size - 1;
+      return true;
+   }
+
+   if (!parse(from, first) || first >= size)
+      return false;
+   if (to.empty() || !parse(to, last) || last >= size)
+      last = size - 1;
+   return last >= first;
+}
+
+QByteArray StaticFiles::HttpDate(const QDateTime& time)
+{
+   return QLocale::c().toString(time.toUTC(), httpDateFormat).toLatin1();
+}
+
+QDateTime StaticFiles::ParseHttpDate(std::string_view date)
+{
+   QDateTime time = QLocale::c().toDateTime(QString::fromLatin1(date.data(), qsizetype(date.size())), httpDateFormat);
+   time.setTimeZone(QTimeZone::UTC);
+   return time;
+}
+
+}
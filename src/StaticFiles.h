@@ -0,0 +1,94 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_STATICFILES__H
+#define MAU_STATICFILES__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QDeadlineTimer>
+#pragma pop_macro("new")
+
+#include <memory>
+#include <string_view>
+
+//****************************************************************************
+//!
+//! \brief Lookup of the files served by file endpoints.
+//!
+//! Resolves request paths below the directory of an endpoint and caches the
+//! metadata of the files, so a request for an unchanged file doesn't stat
+//! the file system again until the metadata expires.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class StaticFiles
+{
+public:
+   struct FileInfo {
+      QString path;                                //!< Absolute path of the file
+      bool exists = false;                         //!< If the path is a readable file
+      bool directory = false;                      //!< If the path is a directory
+      qint64 size = 0;                             //!< Size of the file in bytes
+      QDateTime lastModified;                      //!< Modification time, in seconds as HTTP dates have
+      QByteArray lastModifiedHttp;                 //!< #lastModified as HTTP date
+      QByteArray etag;                             //!< Entity tag from #size and #lastModified, quoted
+      QByteArray contentType;                      //!< Media type by the file name extension
+      QDeadlineTimer expiry;                       //!< When the metadata has to be read again
+   };
+
+   StaticFiles(int metadataTtl, int maxEntries);
+
+   std::shared_ptr<const FileInfo> Info(const QString& path);
+      //!< \brief Metadata of the file at #path, cached for the metadata TTL.
+
+   std::shared_ptr<const FileInfo> Refresh(const QString& path);
+      //!< \brief Reads the metadata of the file at #path again, replacing the cached entry.
+
+   static QString Resolve(const QString& directory, std::string_view relativePath);
+      //!< \brief Resolves the percent-encoded #relativePath below #directory.
+      //!< \return The absolute path, or a null string if it leaves #directory.
+
+   static bool ParseRange(std::string_view range, qint64 size, qint64& first, qint64& last);
+      //!< \brief Parses a Range header value with a single byte range.
+      //!< \return If the range is satisfiable. #first and #last are inclusive.
+
+   static QByteArray HttpDate(const QDateTime& time);
+   static QDateTime ParseHttpDate(std::string_view date);
+
+private:
+   mutable QMutex mutex;
+   QCache<QString, std::shared_ptr<const FileInfo>> cache;
+   int metadataTtl;
+};
+
+}
+
+#endif
@@ -0,0 +1,424 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Global.h"
+#include "TlsContext.h"
+
+#include <cstring>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   #include <openssl/core_names.h>
+   #include <openssl/params.h>
+#else
+   #include <openssl/hmac.h>
+#endif
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//!
+//! \brief OpenSSL callbacks of the configured contexts.
+//! They find their TlsContext through the ex data of the SSL context.
+//!
+//*****************************************************************************
+struct TlsCallbacks
+{
+   static int ContextIndex()
+   {
+      static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+      return index;
+   }
+
+   static int GenerationIndex()
+   {
+      static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+      return index;
+   }
+
+   static int CountedIndex()
+   {
+      static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+      return index;
+   }
+
+   static int OpenIndex()
+   {
+      static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, &Closed);
+      return index;
+   }
+
+   // Counts a connection as open on its first ClientHello, or refuses it if the limit is reached.
+   static int ClientHello(SSL* ssl, int* alert, void* argument)
+   {
+      TlsContext* context = TlsContext::Of(ssl);
+      if (!context || SSL_get_ex_data(ssl, OpenIndex()))
+         return SSL_CLIENT_HELLO_SUCCESS;   // Not configured, or a second ClientHello after a HelloRetryRequest
+
+      int limit = context->maxConnections.load(std::memory_order_relaxed);
+      if (limit > 0 && context->openConnections.load(std::memory_order_relaxed) >= limit) {
+         context->refusedConnections.fetch_add(1, std::memory_order_relaxed);
+         *alert = SSL_AD_HANDSHAKE_FAILURE;
+         return SSL_CLIENT_HELLO_ERROR;
+      }
+
+      SSL_set_ex_data(ssl, OpenIndex(), context);
+      context->openConnections.fetch_add(1, std::memory_order_relaxed);
+      return SSL_CLIENT_HELLO_SUCCESS;
+   }
+
+   // Free function of OpenIndex(), counts the connection as closed when OpenSSL frees it.
+   static void Closed(void* parent, void* pointer, CRYPTO_EX_DATA* data, int index, long argl, void* argp)
+   {
+      if (pointer)
+         static_cast<TlsContext*>(pointer)->openConnections.fetch_sub(1, std::memory_order_relaxed);
+   }
+
+   // Hands the current credentials to a new connection if its context was configured with older ones.
+   static int Certificate(SSL* ssl, void* argument)
+   {
+      TlsContext* context = TlsContext::Of(ssl);
+      if (!context)
+         return 1;
+
+      std::shared_ptr<const TlsContext::Snapshot> credentials = context->credentials.load(std::memory_order_acquire);
+      quintptr configured = reinterpret_cast<quintptr>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), GenerationIndex()));
+      if (!credentials || credentials->generation == configured)
+         return 1;
+
+      // The connection takes references, so the snapshot may be replaced while it is open.
+      bool used = SSL_use_certificate(ssl, credentials->certificate) == 1
+         && SSL_use_PrivateKey(ssl, credentials->key) == 1
+         && SSL_set1_chain(ssl, credentials->chain) == 1;
+      return used ? 1 : 0;
+   }
+
+   // Counts every handshake once. TLS 1.3 servers may report the end of the handshake again after sending tickets.
+   static void Info(const SSL* ssl, int where, int ret)
+   {
+      if (!(where & SSL_CB_HANDSHAKE_DONE))
+         return;
+
+      SSL* connection = const_cast<SSL*>(ssl);
+      TlsContext* context = TlsContext::Of(ssl);
+      if (!context || SSL_get_ex_data(connection, CountedIndex()))
+         return;
+
+      SSL_set_ex_data(connection, CountedIndex(), context);
+      if (SSL_session_reused(connection))
+         context->resumedHandshakes.fetch_add(1, std::memory_order_relaxed);
+      else
+         context->fullHandshakes.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   // Selects the application protocol (ALPN, RFC 7301). Webcc speaks HTTP/1.x only, so h2 is never selected.
+   static int SelectProtocol(SSL* ssl, const unsigned char** out, unsigned char* outLength, const unsigned char* in, unsigned int inLength, void* argument)
+   {
+      static const unsigned char protocols[] = "\x08http/1.1\x08http/1.0";
+
+      unsigned char* selected = nullptr;
+      if (SSL_select_next_proto(&selected, outLength, protocols, sizeof(protocols) - 1, in, inLength) != OPENSSL_NPN_NEGOTIATED)
+         return SSL_TLSEXT_ERR_ALERT_FATAL;   // no_application_protocol
+
+      *out = selected;
+      return SSL_TLSEXT_ERR_OK;
+   }
+
+   // Encrypts tickets with the current key and decrypts them with the current or previous key, see SSL_CTX_set_tlsext_ticket_key_evp_cb().
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   static int TicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int encrypt)
+#else
+   static int TicketKey(SSL* ssl, unsigned char* name, unsigned char* iv, EVP_CIPHER_CTX* cipher, HMAC_CTX* mac, int encrypt)
+#endif
+   {
+      TlsContext* context = TlsContext::Of(ssl);
+      if (!context)
+         return -1;
+
+      TlsContext::TicketKey key;
+      int result = 1;
+      if (encrypt) {
+         if (!context->EncryptionKey(key) || RAND_bytes(iv, EVP_MAX_IV_LENGTH) <= 0)
+            return -1;
+         std::memcpy(name, key.name, sizeof(key.name));
+         if (EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes, iv) <= 0)
+            return -1;
+      } else {
+         result = context->DecryptionKey(name, key);
+         if (result == 0)
+            return 0;   // Unknown key, full handshake
+         if (EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes, iv) <= 0)
+            return -1;
+      }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      char digest[] = "SHA256";
+      OSSL_PARAM parameters[] = {
+         OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac, sizeof(key.hmac)),
+         OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+         OSSL_PARAM_construct_end()
+      };
+      if (EVP_MAC_CTX_set_params(mac, parameters) <= 0)
+         return -1;
+#else
+      if (HMAC_Init_ex(mac, key.hmac, sizeof(key.hmac), EVP_sha256(), nullptr) <= 0)
+         return -1;
+#endif
+      return result;
+   }
+};
+
+//*****************************************************************************
+//!
+//! \brief Applies the options to an SSL context.
+//! Installs the callbacks counting the handshakes and connections, managing
+//! the session ticket keys and selecting the application protocol.
+//!
+//! \param   context  The OpenSSL context of a listener.
+//! \param   error    Set to the setting that failed.
+//! \returns bool     If the options could be applied.
+//!
+//*****************************************************************************
+bool TlsContext::Configure(SSL_CTX* context, QString& error)
+{
+   static const unsigned char sessionIdContext[] = "MauCppHttpServer";
+
+   std::shared_ptr<const Snapshot> snapshot = credentials.load(std::memory_order_acquire);
+   if (!snapshot) {
+      error = "No certificate.";
+      return false;
+   }
+   bool used = SSL_CTX_use_certificate(context, snapshot->certificate) == 1
+      && SSL_CTX_use_PrivateKey(context, snapshot->key) == 1
+      && SSL_CTX_set1_chain(context, snapshot->chain) == 1;
+   if (!used) {
+      error = "The certificate can't be used.";
+      return false;
+   }
+
+   SSL_CTX_set_ex_data(context, TlsCallbacks::ContextIndex(), this);
+   SSL_CTX_set_ex_data(context, TlsCallbacks::GenerationIndex(), reinterpret_cast<void*>(quintptr(snapshot->generation)));
+   SSL_CTX_set_info_callback(context, &TlsCallbacks::Info);
+   SSL_CTX_set_cert_cb(context, &TlsCallbacks::Certificate, nullptr);
+   SSL_CTX_set_alpn_select_cb(context, &TlsCallbacks::SelectProtocol, nullptr);
+   SSL_CTX_set_client_hello_cb(context, &TlsCallbacks::ClientHello, nullptr);
+
+   SSL_CTX_set_session_id_context(context, sessionIdContext, sizeof(sessionIdContext) - 1);
+   SSL_CTX_set_timeout(context, options.sessionTimeout);
+   if (options.sessionCacheSize > 0) {
+      SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(context, options.sessionCacheSize);
+   } else {
+      SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_OFF);
+   }
+
+   if (options.sessionTickets) {
+      SSL_CTX_clear_options(context, SSL_OP_NO_TICKET);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+      SSL_CTX_set_tlsext_ticket_key_evp_cb(context, &TlsCallbacks::TicketKey);
+#else
+      SSL_CTX_set_tlsext_ticket_key_cb(context, &TlsCallbacks::TicketKey);
+#endif
+   } else {
+      SSL_CTX_set_options(context, SSL_OP_NO_TICKET);
+      SSL_CTX_set_num_tickets(context, 0);
+   }
+
+   if (options.serverPreference)
+      SSL_CTX_set_options(context, SSL_OP_CIPHER_SERVER_PREFERENCE);
+   else
+      SSL_CTX_clear_options(context, SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+   if (!options.groups.isEmpty() && SSL_CTX_set1_groups_list(context, options.groups.toLatin1().constData()) != 1) {
+      error = QString("Invalid TLS groups '%1'.").arg(options.groups);
+      return false;
+   }
+   if (!options.ciphers.isEmpty() && SSL_CTX_set_cipher_list(context, options.ciphers.toLatin1().constData()) != 1) {
+      error = QString("Invalid TLS ciphers '%1'.").arg(options.ciphers);
+      return false;
+   }
+   if (!options.cipherSuites.isEmpty() && SSL_CTX_set_ciphersuites(context, options.cipherSuites.toLatin1().constData()) != 1) {
+      error = QString("Invalid TLS 1.3 cipher suites '%1'.").arg(options.cipherSuites);
+      return false;
+   }
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief Replaces certificate and private key.
+//! Contexts configured later use them right away, contexts configured
+//! before with the next handshake, see TlsCallbacks::Certificate().
+//!
+//! \param   certificatePem  The certificate, followed by its chain.
+//! \param   privateKeyPem   The unencrypted private key of the certificate.
+//! \param   error           Set to the reason if the credentials are refused.
+//! \returns bool            If the credentials were replaced.
+//!
+//*****************************************************************************
+bool TlsContext::Credentials(const QByteArray& certificatePem, const QByteArray& privateKeyPem, QString& error)
+{
+   auto next = std::make_shared<Snapshot>();
+
+   BIO* bio = BIO_new_mem_buf(certificatePem.constData(), int(certificatePem.size()));
+   next->certificate = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
+   while (X509* intermediate = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+      if (!next->chain)
+         next->chain = sk_X509_new_null();
+      sk_X509_push(next->chain, intermediate);
+   }
+   BIO_free(bio);
+
+   bio = BIO_new_mem_buf(privateKeyPem.constData(), int(privateKeyPem.size()));
+   next->key = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+   BIO_free(bio);
+   ERR_clear_error();   // Reading past the last certificate leaves an error
+
+   if (!next->certificate || !next->key) {
+      error = "Invalid certificate or private key.";
+      return false;
+   }
+   if (X509_check_private_key(next->certificate, next->key) != 1) {
+      ERR_clear_error();
+      error = "The private key doesn't belong to the certificate.";
+      return false;
+   }
+
+   next->generation = generations.fetch_add(1, std::memory_order_relaxed) + 1;
+   credentials.store(std::move(next), std::memory_order_release);
+   return true;
+}
+
+//*****************************************************************************
+//! Releases the certificates and the key.
+//*****************************************************************************
+TlsContext::Snapshot::~Snapshot()
+{
+   X509_free(certificate);
+   if (chain)
+      sk_X509_pop_free(chain, X509_free);
+   EVP_PKEY_free(key);
+}
+
+//*****************************************************************************
+//! Handshake counters of all configured contexts.
+//*****************************************************************************
+HttpServer::TlsStatistics TlsContext::Statistics() const
+{
+   HttpServer::TlsStatistics statistics;
+   statistics.fullHandshakes     = fullHandshakes.load(std::memory_order_relaxed);
+   statistics.resumedHandshakes  = resumedHandshakes.load(std::memory_order_relaxed);
+   statistics.ticketKeyRotations = rotations.load(std::memory_order_relaxed);
+   return statistics;
+}
+
+//*****************************************************************************
+//! Open and refused connections of all configured contexts.
+//*****************************************************************************
+HttpServer::ConnectionStatistics TlsContext::Connections() const
+{
+   HttpServer::ConnectionStatistics statistics;
+   statistics.open    = openConnections.load(std::memory_order_relaxed);
+   statistics.refused = refusedConnections.load(std::memory_order_relaxed);
+   return statistics;
+}
+
+//*****************************************************************************
+//! The TLS context of a connection, null if its SSL context isn't configured.
+//*****************************************************************************
+TlsContext* TlsContext::Of(const SSL* ssl)
+{
+   return static_cast<TlsContext*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), TlsCallbacks::ContextIndex()));
+}
+
+//*****************************************************************************
+//!
+//! \brief The key to encrypt a new ticket with.
+//! Creates the first key and rotates the keys once the current one is older
+//! than the session timeout.
+//!
+//! \param   key   Set to the current key.
+//! \returns bool  False if no random key could be created.
+//!
+//*****************************************************************************
+bool TlsContext::EncryptionKey(TicketKey& key)
+{
+   QMutexLocker lock(&keys);
+   if (!hasCurrent || rotation.hasExpired()) {
+      TicketKey next;
+      if (!NewKey(next))
+         return false;
+
+      if (hasCurrent) {
+         previous = current;
+         hasPrevious = true;
+         rotations.fetch_add(1, std::memory_order_relaxed);
+      }
+      current = next;
+      hasCurrent = true;
+      rotation.setRemainingTime(qint64(options.sessionTimeout) * 1000);
+   }
+
+   key = current;
+   return true;
+}
+
+//*****************************************************************************
+//!
+//! \brief The key a ticket was encrypted with.
+//!
+//! \param   name  Name of the key in the ticket.
+//! \param   key   Set to the key.
+//! \returns int   1 for the current key, 2 for the previous key, so the
+//!                ticket is renewed, and 0 for an unknown key.
+//!
+//*****************************************************************************
+int TlsContext::DecryptionKey(const unsigned char* name, TicketKey& key)
+{
+   QMutexLocker lock(&keys);
+   if (hasCurrent && std::memcmp(name, current.name, sizeof(current.name)) == 0) {
+      key = current;
+      return rotation.hasExpired() ? 2 : 1;
+   }
+   if (hasPrevious && std::memcmp(name, previous.name, sizeof(previous.name)) == 0) {
+      key = previous;
+      return 2;
+   }
+   return 0;
+}
+
+//*****************************************************************************
+//! Creates a random ticket key.
+//*****************************************************************************
+bool TlsContext::NewKey(TicketKey& key)
+{
+   return RAND_bytes(key.name, sizeof(key.name)) > 0
+      && RAND_bytes(key.aes, sizeof(key.aes)) > 0
+      && RAND_bytes(key.hmac, sizeof(key.hmac)) > 0;
+}
+
+}
@@ -0,0 +1,150 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_TLSCONTEXT__H
+#define MAU_TLSCONTEXT__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QDeadlineTimer>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <memory>
+
+#include <openssl/ssl.h>
+
+/***  Global Component Includes  *********************************************/
+
+#ifndef      MAU_HTTPSERVER__H
+   #include "HttpServer.h"
+#endif
+
+//****************************************************************************
+//!
+//! \brief TLS settings shared by the SSL contexts of the HTTPS listeners.
+//!
+//! Configures session caching, session tickets, ECDHE groups and ciphers of
+//! an OpenSSL context. The session ticket keys live here and not in the
+//! contexts, so a ticket issued by one listener resumes on every listener
+//! and across restarts of the server. The keys are rotated after the
+//! session timeout; tickets of the previous key are still accepted and
+//! renewed. Handshakes of all configured contexts are counted. Clients
+//! negotiating the application protocol (ALPN) get HTTP/1.1 or HTTP/1.0.
+//!
+//! Certificate and private key are held as an immutable snapshot. Replacing
+//! the snapshot while the server runs takes effect with the next handshake:
+//! contexts configured with an older snapshot hand the current one to each
+//! new connection when it selects its certificate. Established connections
+//! keep theirs.
+//!
+//! Every connection is counted from its first ClientHello until OpenSSL
+//! frees it, and refused in the handshake if the limit is reached.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class TlsContext
+{
+public:
+   TlsContext() = default;
+   TlsContext(const TlsContext&) = delete;
+   TlsContext& operator=(const TlsContext&) = delete;
+
+   void Options(const HttpServer::TlsOptions& options) { TlsContext::options = options; }
+      //!< \brief Sets the options applied by Configure().
+   HttpServer::TlsOptions Options() const { return options; }
+      //!< \brief The options applied by Configure().
+
+   bool Credentials(const QByteArray& certificatePem, const QByteArray& privateKeyPem, QString& error);
+      //!< \brief Replaces certificate and private key of all configured contexts.
+      //!< Further certificates in #certificatePem form the chain.
+      //!< \return If both are valid and match, else #error describes the failure.
+
+   bool Configure(SSL_CTX* context, QString& error);
+      //!< \brief Applies the credentials and options to #context and installs the callbacks.
+      //!< The TLS context has to outlive #context.
+      //!< \return If the options could be applied, else #error describes the failure.
+
+   HttpServer::TlsStatistics Statistics() const;
+      //!< \brief Handshake counters of all configured contexts.
+
+   void MaxConnections(int connections) { maxConnections.store(connections, std::memory_order_relaxed); }
+      //!< \brief Sets the number of open connections above which handshakes are refused, 0 for no limit.
+
+   HttpServer::ConnectionStatistics Connections() const;
+      //!< \brief Open and refused connections of all configured contexts.
+
+private:
+   friend struct TlsCallbacks;
+
+   struct Snapshot {
+      Snapshot() = default;
+      Snapshot(const Snapshot&) = delete;
+      Snapshot& operator=(const Snapshot&) = delete;
+      ~Snapshot();
+
+      X509* certificate = nullptr;                 //!< Server certificate
+      STACK_OF(X509)* chain = nullptr;             //!< Intermediate certificates, may be null
+      EVP_PKEY* key = nullptr;                     //!< Private key of #certificate
+      quint64 generation = 0;                      //!< Counts the snapshots, so contexts know if theirs is outdated
+   };
+
+   struct TicketKey {
+      unsigned char name[16];                      //!< Identifies the key in the tickets it encrypted
+      unsigned char aes[32];                       //!< AES-256-CBC key
+      unsigned char hmac[32];                      //!< HMAC-SHA256 key
+   };
+
+   static TlsContext* Of(const SSL* ssl);
+   bool EncryptionKey(TicketKey& key);
+   int DecryptionKey(const unsigned char* name, TicketKey& key);
+   static bool NewKey(TicketKey& key);
+
+   HttpServer::TlsOptions options;
+   std::atomic<std::shared_ptr<const Snapshot>> credentials;   //!< Current certificate and private key
+   std::atomic<quint64> generations{ 0 };
+
+   QMutex keys;                                    //!< Guards the ticket keys
+   TicketKey current = {};                         //!< Key encrypting new tickets
+   TicketKey previous = {};                        //!< Key of the last rotation, still decrypting
+   bool hasCurrent = false;
+   bool hasPrevious = false;
+   QDeadlineTimer rotation;                        //!< When #current is replaced
+
+   std::atomic<quint64> fullHandshakes{ 0 };
+   std::atomic<quint64> resumedHandshakes{ 0 };
+   std::atomic<quint64> rotations{ 0 };
+
+   std::atomic<int> maxConnections{ 0 };
+   std::atomic<qint64> openConnections{ 0 };
+   std::atomic<quint64> refusedConnections{ 0 };
+};
+
+}
+
+#endif
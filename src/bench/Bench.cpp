@@ -0,0 +1,113 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Bench.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSysInfo>
+#include <QtCore/QThread>
+#include <QtCore/QDateTime>
+#pragma pop_macro("new")
+
+#include <algorithm>
+#include <cstdio>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+void Bench::AddMicro(const QString& name, quint64 iterations, double seconds)
+{
+   double nanoseconds = seconds * 1e9 / double(iterations);
+   std::fprintf(stderr, "%-50s %12.1f ns/op\n", qPrintable(name), nanoseconds);
+
+   micro.append(QJsonObject{
+      { "name", name },
+      { "iterations", double(iterations) },
+      { "nsPerOp", nanoseconds }
+   });
+}
+
+//*****************************************************************************
+//!
+//! \brief Adds a load result.
+//! Percentiles are taken by rank from the sorted latencies.
+//!
+//*****************************************************************************
+void Bench::Add(LoadResult& result)
+{
+   std::sort(result.latencies.begin(), result.latencies.end());
+
+   auto percentile = [&](double p) {
+      if (result.latencies.empty())
+         return 0.0;
+      std::size_t rank = std::min(result.latencies.size() - 1, std::size_t(p * double(result.latencies.size())));
+      return double(result.latencies[rank]) / 1e3;
+   };
+
+   double requests = double(result.latencies.size());
+   double throughput = result.seconds > 0.0 ? requests / result.seconds : 0.0;
+   std::fprintf(stderr, "%-50s %10.0f req/s  p50 %8.1f us  p99 %8.1f us  p999 %8.1f us  errors %llu\n",
+      qPrintable(result.name), throughput, percentile(0.5), percentile(0.99), percentile(0.999),
+      static_cast<unsigned long long>(result.errors));
+
+   load.append(QJsonObject{
+      { "name", result.name },
+      { "protocol", result.protocol },
+      { "keepAlive", result.keepAlive },
+      { "connections", result.connections },
+      { "seconds", result.seconds },
+      { "requests", requests },
+      { "errors", double(result.errors) },
+      { "requestsPerSecond", throughput },
+      { "p50us", percentile(0.5) },
+      { "p99us", percentile(0.99) },
+      { "p999us", percentile(0.999) }
+   });
+}
+
+bool Bench::Write(const QString& fileName) const
+{
+   QJsonObject root{
+      { "timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate) },
+      { "host", QSysInfo::machineHostName() },
+      { "kernel", QSysInfo::kernelType() + ' ' + QSysInfo::kernelVersion() },
+      { "cpus", QThread::idealThreadCount() },
+      { "micro", micro },
+      { "load", load }
+   };
+   QByteArray json = QJsonDocument(root).toJson();
+
+   QFile file(fileName);
+   if (fileName == "-") {
+      if (!file.open(stdout, QIODevice::WriteOnly))
+         return false;
+   } else if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      return false;
+   }
+   return file.write(json) == json.size();
+}
+
+}
@@ -0,0 +1,116 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#ifndef MAU_BENCH__H
+#define MAU_BENCH__H
+
+/***  System Includes  *******************************************************/
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QString>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#pragma pop_macro("new")
+
+#include <chrono>
+#include <vector>
+
+//****************************************************************************
+//!
+//! \brief Runs benchmarks and collects their results as JSON.
+//!
+//! A microbenchmark doubles its iteration count until it ran for the
+//! minimum time and reports the time per iteration. Load results report
+//! throughput and latency percentiles. The JSON file is meant to be
+//! compared between releases.
+//!
+//****************************************************************************
+
+namespace mau {
+
+class Bench
+{
+public:
+   typedef std::chrono::steady_clock Clock;
+
+   struct LoadResult {
+      QString name;                                //!< Name of the scenario
+      QString protocol;                            //!< "http" or "https"
+      bool keepAlive = true;                       //!< If connections are reused
+      int connections = 0;                         //!< Concurrent client connections
+      double seconds = 0.0;                        //!< Duration of the run
+      quint64 errors = 0;                          //!< Failed requests
+      std::vector<qint64> latencies;               //!< Latencies of the successful requests in nanoseconds
+   };
+
+   explicit Bench(double minSeconds = 0.25) : minSeconds(minSeconds) {}
+
+   template<typename Function>
+   void Measure(const QString& name, Function&& function);
+      //!< \brief Measures #function, called with the number of iterations to run.
+
+   void Add(LoadResult& result);
+      //!< \brief Adds a load result. Sorts its latencies.
+
+   bool Write(const QString& fileName) const;
+      //!< \brief Writes the results as JSON to #fileName, or to stdout if it is "-".
+
+   template<typename T>
+   static void Keep(const T& value);
+      //!< \brief Keeps the compiler from optimizing #value away.
+
+private:
+   void AddMicro(const QString& name, quint64 iterations, double seconds);
+
+   double minSeconds;
+   QJsonArray micro;
+   QJsonArray load;
+};
+
+template<typename Function>
+void Bench::Measure(const QString& name, Function&& function)
+{
+   for (quint64 iterations = 1;; iterations *= 2) {
+      Clock::time_point start = Clock::now();
+      function(iterations);
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (seconds >= minSeconds || iterations >= (quint64(1) << 40)) {
+         AddMicro(name, iterations, seconds);
+         return;
+      }
+   }
+}
+
+template<typename T>
+void Bench::Keep(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   asm volatile("" : : "r,m"(value) : "memory");
+#else
+   static volatile const void* sink;
+   sink = &value;
+#endif
+}
+
+}
+
+#endif
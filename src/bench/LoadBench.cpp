@@ -0,0 +1,439 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Bench.h"
+
+#include "HttpServerWebcc.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+using boost::asio::ip::tcp;
+
+//*****************************************************************************
+//!
+//! \brief Server under load.
+//! Answers every request with a fixed body, so the numbers show the cost of
+//! the server and not of a callback.
+//!
+//*****************************************************************************
+class BenchServer : public HttpServerWebcc
+{
+public:
+   BenchServer() : body(std::make_shared<const std::string>(1024, 'x')) {}
+
+protected:
+   HttpResponse OnRequest(const QString& endpoint, const HttpRequestView& request) override
+   {
+      HttpResponse response;
+      response.statusCode = 200;
+      response.headers["Content-Type"] = "text/plain";
+      response.sharedBody = body;
+      return response;
+   }
+
+private:
+   SharedBuffer body;
+};
+
+//*****************************************************************************
+//! Creates a self-signed certificate for localhost with a RSA key.
+//*****************************************************************************
+static bool CreateCertificate(QByteArray& certificate, QByteArray& privateKey)
+{
+   auto toPem = [](BIO* bio) {
+      char* data = nullptr;
+      long size = BIO_get_mem_data(bio, &data);
+      return QByteArray(data, size);
+   };
+
+   EVP_PKEY* key = nullptr;
+   EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+   bool generated = context && EVP_PKEY_keygen_init(context) > 0
+      && EVP_PKEY_CTX_set_rsa_keygen_bits(context, 2048) > 0
+      && EVP_PKEY_keygen(context, &key) > 0;
+   EVP_PKEY_CTX_free(context);
+   if (!generated)
+      return false;
+
+   X509* x509 = X509_new();
+   X509_set_version(x509, 2);
+   ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+   X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+   X509_gmtime_adj(X509_getm_notAfter(x509), 24 * 60 * 60);
+   X509_set_pubkey(x509, key);
+   X509_NAME* name = X509_get_subject_name(x509);
+   X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+   X509_set_issuer_name(x509, name);
+   bool certified = X509_sign(x509, key, EVP_sha256()) > 0;
+
+   BIO* certificateBio = BIO_new(BIO_s_mem());
+   BIO* keyBio = BIO_new(BIO_s_mem());
+   bool written = certified
+      && PEM_write_bio_X509(certificateBio, x509) > 0
+      && PEM_write_bio_PrivateKey(keyBio, key, nullptr, nullptr, 0, nullptr, nullptr) > 0;
+   if (written) {
+      certificate = toPem(certificateBio);
+      privateKey = toPem(keyBio);
+   }
+
+   BIO_free(certificateBio);
+   BIO_free(keyBio);
+   X509_free(x509);
+   EVP_PKEY_free(key);
+   return written;
+}
+
+//*****************************************************************************
+//!
+//! \brief Sends a request and reads the response.
+//! Responses have to have a Content-Length, which the bench server always
+//! sends.
+//!
+//! \returns int  Status code of the response, 0 on a malformed response.
+//!
+//*****************************************************************************
+template<typename Stream>
+static int Exchange(Stream& stream, boost::asio::streambuf& buffer, const std::string& request)
+{
+   boost::asio::write(stream, boost::asio::buffer(request));
+
+   std::size_t headerSize = boost::asio::read_until(stream, buffer, "\r\n\r\n");
+   std::string header(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_begin(buffer.data()) + headerSize);
+
+   int statusCode = header.size() > 12 ? std::atoi(header.c_str() + 9) : 0;   // "HTTP/1.1 200 OK"
+
+   std::size_t contentLength = 0;
+   for (std::size_t line = header.find("\r\n"); line != std::string::npos; line = header.find("\r\n", line + 2)) {
+      static const char name[] = "content-length:";
+      std::size_t i = 0;
+      while (i < sizeof(name) - 1 && line + 2 + i < header.size() && std::tolower(header[line + 2 + i]) == name[i])
+         i++;
+      if (i == sizeof(name) - 1) {
+         contentLength = std::strtoull(header.c_str() + line + 2 + i, nullptr, 10);
+         break;
+      }
+   }
+
+   std::size_t available = buffer.size() - headerSize;
+   if (available < contentLength)
+      boost::asio::read(stream, buffer, boost::asio::transfer_exactly(contentLength - available));
+   buffer.consume(headerSize + contentLength);
+   return statusCode;
+}
+
+//*****************************************************************************
+//!
+//! \brief Client connection of the load generator.
+//! Runs requests back to back until the deadline. Without keep-alive, every
+//! request opens a connection of its own and the connect (and handshake)
+//! is part of its latency.
+//!
+//*****************************************************************************
+template<typename Stream, typename Connect>
+static void RunClient(Connect connect, bool keepAlive, Bench::Clock::time_point deadline, Bench::LoadResult& result)
+{
+   const std::string request = std::string("GET /bench HTTP/1.1\r\nHost: localhost\r\nConnection: ")
+      + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+
+   std::unique_ptr<Stream> stream;
+   boost::asio::streambuf buffer;
+
+   while (Bench::Clock::now() < deadline) {
+      Bench::Clock::time_point start = Bench::Clock::now();
+      try {
+         if (!stream) {
+            stream = connect();
+            buffer.consume(buffer.size());
+         }
+
+         int statusCode = Exchange(*stream, buffer, request);
+         if (statusCode == 200)
+            result.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Bench::Clock::now() - start).count());
+         else
+            result.errors++;
+
+         if (!keepAlive)
+            stream.reset();
+      } catch (const std::exception&) {
+         result.errors++;
+         stream.reset();
+      }
+   }
+}
+
+//*****************************************************************************
+//!
+//! \brief Keeps the last session a client thread got from the server.
+//! Called by OpenSSL for every new session, with TLS 1.3 when the ticket
+//! arrives after the handshake.
+//!
+//*****************************************************************************
+static thread_local SSL_SESSION* clientSession = nullptr;
+
+static int KeepSession(SSL* ssl, SSL_SESSION* session)
+{
+   if (clientSession)
+      SSL_SESSION_free(clientSession);
+   clientSession = session;
+   return 1;   // The reference is kept
+}
+
+//*****************************************************************************
+//!
+//! \brief Runs one load scenario with #connections client threads.
+//! The clients are spread round robin over #ports. With #resume, HTTPS
+//! clients resume the session of their previous connection.
+//!
+//*****************************************************************************
+static Bench::LoadResult RunScenario(const QList<int>& ports, bool https, bool keepAlive, bool resume, int connections, double seconds)
+{
+   typedef boost::asio::ssl::stream<tcp::socket> SslStream;
+
+   Bench::Clock::time_point deadline = Bench::Clock::now() + std::chrono::duration_cast<Bench::Clock::duration>(std::chrono::duration<double>(seconds));
+
+   std::vector<Bench::LoadResult> results(connections);
+   std::vector<std::thread> clients;
+   for (int i = 0; i < connections; i++) {
+      clients.emplace_back([&, i]() {
+         tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), quint16(ports[i % ports.size()]));
+         boost::asio::io_context io;
+         if (https) {
+            boost::asio::ssl::context context(boost::asio::ssl::context::tls_client);
+            context.set_verify_mode(boost::asio::ssl::verify_none);
+            if (resume) {
+               SSL_CTX_set_session_cache_mode(context.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+               SSL_CTX_sess_set_new_cb(context.native_handle(), &KeepSession);
+            }
+            RunClient<SslStream>([&]() {
+               auto stream = std::make_unique<SslStream>(io, context);
+               if (clientSession)
+                  SSL_set_session(stream->native_handle(), clientSession);
+               stream->lowest_layer().connect(endpoint);
+               stream->lowest_layer().set_option(tcp::no_delay(true));
+               stream->handshake(boost::asio::ssl::stream_base::client);
+               return stream;
+            }, keepAlive, deadline, results[i]);
+
+            if (clientSession) {
+               SSL_SESSION_free(clientSession);
+               clientSession = nullptr;
+            }
+         } else {
+            RunClient<tcp::socket>([&]() {
+               auto socket = std::make_unique<tcp::socket>(io);
+               socket->connect(endpoint);
+               socket->set_option(tcp::no_delay(true));
+               return socket;
+            }, keepAlive, deadline, results[i]);
+         }
+      });
+   }
+   for (std::thread& client : clients)
+      client.join();
+
+   Bench::LoadResult total;
+   total.protocol = https ? "https" : "http";
+   total.keepAlive = keepAlive;
+   total.connections = connections;
+   total.seconds = seconds;
+   total.name = QString("load/%1/%2/%3").arg(total.protocol).arg(keepAlive ? "keepAlive" : resume ? "resume" : "close").arg(connections);
+   for (Bench::LoadResult& result : results) {
+      total.errors += result.errors;
+      total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+   }
+   return total;
+}
+
+//*****************************************************************************
+//!
+//! \brief Loopback load over HTTP and HTTPS, with and without keep-alive.
+//! HTTPS without keep-alive runs with full handshakes and with resumed
+//! sessions. The handshake counters of the server are printed.
+//!
+//! \param bench        Collects the results.
+//! \param seconds      Duration of every scenario.
+//! \param connections  Concurrent client connections.
+//! \param workers      Worker threads of the server.
+//!
+//*****************************************************************************
+void RunLoadBench(Bench& bench, double seconds, int connections, int workers)
+{
+   QByteArray certificate, privateKey;
+   bool haveCertificate = CreateCertificate(certificate, privateKey);
+   if (!haveCertificate)
+      std::fprintf(stderr, "Couldn't create a certificate, skipping HTTPS.\n");
+
+   for (bool https : { false, true }) {
+      if (https && !haveCertificate)
+         continue;
+
+      BenchServer server;
+      server.Address("127.0.0.1");
+      server.Port(0);
+      server.Threads(workers, qMax(1, workers / 2));
+      server.AddEndpoint("/bench", HttpServer::GET);
+      if (https) {
+         server.Protocol(HttpServer::HTTPS);
+         server.SetCertificate(certificate, HttpServer::PEM);
+         server.SetPrivateKey(privateKey, HttpServer::PEM, HttpServer::RSA, QString());
+      } else {
+         server.Protocol(HttpServer::HTTP);
+      }
+
+      if (!server.Start()) {
+         std::fprintf(stderr, "Couldn't start the %s server.\n", https ? "HTTPS" : "HTTP");
+         continue;
+      }
+
+      struct Mode { bool keepAlive; bool resume; };
+      for (Mode mode : { Mode{ true, false }, Mode{ false, false }, Mode{ false, true } }) {
+         if (mode.resume && !https)
+            continue;
+
+         HttpServer::TlsStatistics before = server.MetricsSnapshot().tls;
+         Bench::LoadResult result = RunScenario({ server.Port() }, https, mode.keepAlive, mode.resume, connections, seconds);
+         bench.Add(result);
+
+         if (https) {
+            HttpServer::TlsStatistics after = server.MetricsSnapshot().tls;
+            std::fprintf(stderr, "%s: %llu full, %llu resumed handshakes\n", qPrintable(result.name),
+               static_cast<unsigned long long>(after.fullHandshakes - before.fullHandshakes),
+               static_cast<unsigned long long>(after.resumedHandshakes - before.resumedHandshakes));
+         }
+      }
+
+      server.Stop();
+   }
+}
+
+//*****************************************************************************
+//!
+//! \brief Connection rate of short-lived HTTP clients.
+//! Every request opens a connection of its own, so the numbers are bound by
+//! accepting connections. Compares one acceptor with one I/O loop, one
+//! acceptor with several I/O loops and one listen endpoint per acceptor,
+//! each with a port, I/O loop and thread of its own. Webcc can't share a port
+//! between acceptors (SO_REUSEPORT), so the clients are spread over the
+//! ports instead of the kernel spreading the connections.
+//!
+//! \param bench        Collects the results.
+//! \param seconds      Duration of every scenario.
+//! \param connections  Concurrent client connections.
+//! \param acceptors    Acceptors, respectively I/O loops, of the multi-acceptor scenarios.
+//!
+//*****************************************************************************
+void RunAcceptBench(Bench& bench, double seconds, int connections, int acceptors)
+{
+   struct Scenario {
+      const char* name;
+      int listeners;
+      int loops;
+   };
+
+   const Scenario scenarios[] = {
+      { "single",    1,         1         },
+      { "loops",     1,         acceptors },
+      { "listeners", acceptors, 1         }
+   };
+
+   for (const Scenario& scenario : scenarios) {
+      BenchServer server;
+      server.Protocol(HttpServer::HTTP);
+      server.Address("127.0.0.1");
+      server.Port(0);
+      server.Threads(1, scenario.loops);
+      server.AddEndpoint("/bench", HttpServer::GET);
+      for (int i = 1; i < scenario.listeners; i++)
+         server.AddListenEndpoint({ "127.0.0.1", 0 });
+
+      if (!server.Start()) {
+         std::fprintf(stderr, "Couldn't start the server of the '%s' accept scenario.\n", scenario.name);
+         continue;
+      }
+
+      QList<int> ports;
+      for (const HttpServer::ListenEndpoint& endpoint : server.ListenEndpoints())
+         ports.append(endpoint.port);
+
+      Bench::LoadResult result = RunScenario(ports, false, false, false, connections, seconds);
+      result.name = QString("accept/%1/%2/%3").arg(scenario.name).arg(qMax(scenario.listeners, scenario.loops)).arg(connections);
+      bench.Add(result);
+
+      server.Stop();
+   }
+}
+
+//*****************************************************************************
+//!
+//! \brief Startup and shutdown of server instances.
+//! Creates, starts, stops and destroys a server on an ephemeral port, as
+//! tests and devices starting many instances do. Start() returns when the
+//! server accepts connections, so the time covers the whole startup.
+//!
+//! \param bench  Collects the results.
+//!
+//*****************************************************************************
+void RunStartupBench(Bench& bench)
+{
+   for (int listeners : { 1, 4 }) {
+      bench.Measure(QString("server/startStop/%1").arg(listeners), [&](quint64 iterations) {
+         for (quint64 i = 0; i < iterations; i++) {
+            BenchServer server;
+            server.Protocol(HttpServer::HTTP);
+            server.Address("127.0.0.1");
+            server.Port(0);
+            server.AddEndpoint("/bench", HttpServer::GET);
+            for (int j = 1; j < listeners; j++)
+               server.AddListenEndpoint({ "127.0.0.1", 0 });
+
+            bool started = server.Start();
+            Bench::Keep(started);
+            server.Stop();
+         }
+      });
+   }
+}
+
+}
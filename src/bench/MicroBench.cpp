@@ -0,0 +1,211 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Bench.h"
+
+#include "Exception.h"
+#include "RouteTrie.h"
+#include "HttpRequestViewWebcc.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QRandomGenerator>
+#pragma pop_macro("new")
+
+#include <string>
+#include <vector>
+
+#include "webcc/request_builder.h"
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//*****************************************************************************
+//!
+//! \brief Builds a route table of #count endpoints.
+//! The endpoints mix path variables, literal-only paths and '#' wildcards,
+//! as a device API does.
+//!
+//*****************************************************************************
+static RouteTrie BuildRoutes(int count, std::vector<std::string>& hits, std::vector<std::string>& misses)
+{
+   RouteTrie trie;
+   for (int i = 0; i < count; i++) {
+      switch (i % 3) {
+         case 0: trie.Insert(QString("/api/v1/r%1/items/{id}").arg(i), HttpServer::GET); break;
+         case 1: trie.Insert(QString("/api/v1/r%1/status").arg(i), HttpServer::GET); break;
+         case 2: trie.Insert(QString("/data/r%1/#").arg(i), HttpServer::GET); break;
+      }
+   }
+
+   QRandomGenerator random(42);
+   for (int i = 0; i < 1024; i++) {
+      int route = random.bounded(count);
+      switch (route % 3) {
+         case 0: hits.push_back("/api/v1/r" + std::to_string(route) + "/items/" + std::to_string(i)); break;
+         case 1: hits.push_back("/api/v1/r" + std::to_string(route) + "/status"); break;
+         case 2: hits.push_back("/data/r" + std::to_string(route) + "/2024/06/log.bin"); break;
+      }
+      misses.push_back("/api/v1/r" + std::to_string(route) + "/unknown/" + std::to_string(i));
+   }
+   return trie;
+}
+
+//*****************************************************************************
+//! Route lookups with 10 to 10,000 registered endpoints.
+//*****************************************************************************
+void RunRoutingBench(Bench& bench)
+{
+   for (int count : { 10, 100, 1000, 10000 }) {
+      std::vector<std::string> hits, misses;
+
+      RouteTrie trie = BuildRoutes(count, hits, misses);
+      bench.Measure(QString("routing/copy/%1").arg(count), [&](quint64 iterations) {
+         for (quint64 i = 0; i < iterations; i++) {
+            RouteTrie copy(trie);   // Every AddEndpoint() publishes a copy
+            Bench::Keep(copy);
+         }
+      });
+
+      bench.Measure(QString("routing/find/%1").arg(count), [&](quint64 iterations) {
+         for (quint64 i = 0; i < iterations; i++) {
+            RouteTrie::Match match;
+            Bench::Keep(trie.Find(hits[i % hits.size()], HttpServer::GET, match));
+            Bench::Keep(match);
+         }
+      });
+
+      bench.Measure(QString("routing/notFound/%1").arg(count), [&](quint64 iterations) {
+         for (quint64 i = 0; i < iterations; i++) {
+            RouteTrie::Match match;
+            Bench::Keep(trie.Find(misses[i % misses.size()], HttpServer::GET, match));
+         }
+      });
+
+      bench.Measure(QString("routing/methodNotAllowed/%1").arg(count), [&](quint64 iterations) {
+         for (quint64 i = 0; i < iterations; i++) {
+            RouteTrie::Match match;
+            Bench::Keep(trie.Find(hits[i % hits.size()], HttpServer::POST, match));
+         }
+      });
+   }
+}
+
+//*****************************************************************************
+//! The conversions ProcessRequest() does for the OnRequest() callbacks.
+//*****************************************************************************
+void RunConversionBench(Bench& bench)
+{
+   RouteTrie trie;
+   trie.Insert("/api/v1/devices/{device}/parameters/{parameter}", HttpServer::ALL);
+
+   webcc::RequestPtr get = webcc::RequestBuilder{}
+      .Get("http://localhost:8080/api/v1/devices/sensor-7/parameters/exposure?unit=us&verbose=true")
+      .Header("Accept", "application/json")
+      .Header("X-Request-Id", "0f8fad5b-d9cb-469f-a165-70867728950e")
+      ();
+   webcc::RequestPtr post = webcc::RequestBuilder{}
+      .Post("http://localhost:8080/api/v1/devices/sensor-7/parameters/exposure")
+      .Header("Content-Type", "application/json")
+      .Body(std::string(16 * 1024, 'x'))
+      ();
+
+   QString serverName("http://127.0.0.1:8080");
+   RouteTrie::Match match;
+   trie.Find(get->url().path(), HttpServer::GET, match);
+
+   bench.Measure("conversion/view/header", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++)
+         Bench::Keep(view.Header("X-Request-Id"));
+   });
+
+   bench.Measure("conversion/view/query", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++)
+         Bench::Keep(view.Query("verbose"));
+   });
+
+   bench.Measure("conversion/view/pathVariable", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++)
+         Bench::Keep(view.PathVariable("parameter"));
+   });
+
+   bench.Measure("conversion/toPathInfo", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++) {
+         HttpServer::PathInfo pathInfo = view.ToPathInfo();
+         Bench::Keep(pathInfo);
+      }
+   });
+
+   bench.Measure("conversion/toRequest/get", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++) {
+         HttpServer::HttpRequest request = view.ToRequest();
+         Bench::Keep(request);
+      }
+   });
+
+   RouteTrie::Match postMatch;
+   trie.Find(post->url().path(), HttpServer::POST, postMatch);
+   bench.Measure("conversion/toRequest/post16k", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*post, postMatch, HttpServer::POST, serverName);
+      for (quint64 i = 0; i < iterations; i++) {
+         HttpServer::HttpRequest request = view.ToRequest();
+         Bench::Keep(request);
+      }
+   });
+
+   bench.Measure("conversion/url", [&](quint64 iterations) {
+      HttpRequestViewWebcc view(*get, match, HttpServer::GET, serverName);
+      for (quint64 i = 0; i < iterations; i++) {
+         QString url = view.Url();
+         Bench::Keep(url);
+      }
+   });
+}
+
+//*****************************************************************************
+//! Formatting of exception messages, done for every logged error.
+//*****************************************************************************
+void RunExceptionBench(Bench& bench)
+{
+   static const EventMsg message({
+      { "en-US", "HTTP server '%1', Endpoint '%2': Invalid status code '%3'." },
+      { "de-DE", "HTTP-Server '%1', Endpunkt '%2': Ungültiger Status-Code '%3'." }
+   });
+
+   Exception exception("Bench::InvalidStatusCodeEx", Exception::error, message);
+   exception.Arg("http://127.0.0.1:8080").Arg("/api/v1/devices/{device}").Arg(999);
+
+   bench.Measure("exception/msg", [&](quint64 iterations) {
+      for (quint64 i = 0; i < iterations; i++) {
+         EventMsg msg = exception.Msg();
+         Bench::Keep(msg);
+      }
+   });
+}
+
+}
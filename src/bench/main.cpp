@@ -0,0 +1,103 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+
+#include "Bench.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QThread>
+#pragma pop_macro("new")
+
+#include <cstdio>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+   void RunRoutingBench(Bench& bench);
+   void RunConversionBench(Bench& bench);
+   void RunExceptionBench(Bench& bench);
+   void RunStartupBench(Bench& bench);
+   void RunLoadBench(Bench& bench, double seconds, int connections, int workers);
+   void RunAcceptBench(Bench& bench, double seconds, int connections, int acceptors);
+}
+
+//*****************************************************************************
+//!
+//! \brief Runs the benchmarks and writes the results as JSON.
+//!
+//! MauCppHttpServerBench [--micro] [--load] [--accept] [--duration <s>]
+//!                       [--connections <n>] [--workers <n>] [--acceptors <n>]
+//!                       [--output <file>]
+//!
+//*****************************************************************************
+int main(int argc, char* argv[])
+{
+   QCoreApplication application(argc, argv);
+
+   QCommandLineParser parser;
+   parser.setApplicationDescription("Benchmarks and loopback load generator of MauCppHttpServer.");
+   parser.addHelpOption();
+   QCommandLineOption microOption("micro", "Run the microbenchmarks.");
+   QCommandLineOption loadOption("load", "Run the load generator.");
+   QCommandLineOption acceptOption("accept", "Run the connection rate benchmark.");
+   QCommandLineOption durationOption("duration", "Seconds per load scenario.", "seconds", "5");
+   QCommandLineOption connectionsOption("connections", "Concurrent client connections.", "count", "8");
+   QCommandLineOption workersOption("workers", "Worker threads of the server.", "count", QString::number(qMax(1, QThread::idealThreadCount() / 2)));
+   QCommandLineOption acceptorsOption("acceptors", "Acceptors of the multi-acceptor scenarios.", "count", QString::number(qMax(2, QThread::idealThreadCount() / 2)));
+   QCommandLineOption outputOption("output", "JSON result file, - for stdout.", "file", "MauCppHttpServerBench.json");
+   parser.addOptions({ microOption, loadOption, acceptOption, durationOption, connectionsOption, workersOption, acceptorsOption, outputOption });
+   parser.process(application);
+
+   // Without a selection every benchmark runs.
+   bool all = !parser.isSet(microOption) && !parser.isSet(loadOption) && !parser.isSet(acceptOption);
+   bool micro = all || parser.isSet(microOption);
+   bool load = all || parser.isSet(loadOption);
+   bool accept = all || parser.isSet(acceptOption);
+
+   mau::Bench bench;
+   if (micro) {
+      mau::RunRoutingBench(bench);
+      mau::RunConversionBench(bench);
+      mau::RunExceptionBench(bench);
+   }
+   if (load) {
+      mau::RunStartupBench(bench);
+      mau::RunLoadBench(bench,
+         parser.value(durationOption).toDouble(),
+         qMax(1, parser.value(connectionsOption).toInt()),
+         qMax(1, parser.value(workersOption).toInt()));
+   }
+   if (accept) {
+      mau::RunAcceptBench(bench,
+         parser.value(durationOption).toDouble(),
+         qMax(1, parser.value(connectionsOption).toInt()),
+         qMax(1, parser.value(acceptorsOption).toInt()));
+   }
+
+   if (!bench.Write(parser.value(outputOption))) {
+      std::fprintf(stderr, "Couldn't write '%s'.\n", qPrintable(parser.value(outputOption)));
+      return 1;
+   }
+   return 0;
+}
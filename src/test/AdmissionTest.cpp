@@ -0,0 +1,137 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "Admission.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <memory>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of the slots and the queue of AdmissionGate.
+//!
+//****************************************************************************
+
+class AdmissionTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void LimitsConcurrentRequests();
+   void RefusesWithoutQueue();
+   void QueuedRequestGetsFreedSlot();
+   void QueuedRequestTimesOut();
+   void RefusesWhenQueueIsFull();
+   void SlotLeavesGate();
+};
+
+void AdmissionTest::LimitsConcurrentRequests()
+{
+   AdmissionGate gate(2, 0, 0);
+   QVERIFY(gate.Enter());
+   QVERIFY(gate.Enter());
+   QVERIFY(!gate.Enter());
+
+   gate.Leave();
+   QVERIFY(gate.Enter());
+}
+
+void AdmissionTest::RefusesWithoutQueue()
+{
+   AdmissionGate gate(1, 0, 10000);
+   QVERIFY(gate.Enter());
+
+   QElapsedTimer timer;
+   timer.start();
+   QVERIFY(!gate.Enter());
+   QVERIFY(timer.elapsed() < 5000);
+}
+
+void AdmissionTest::QueuedRequestGetsFreedSlot()
+{
+   AdmissionGate gate(1, 1, 10000);
+   QVERIFY(gate.Enter());
+
+   std::atomic<bool> admitted{ false };
+   std::unique_ptr<QThread> waiting(QThread::create([&] { admitted = gate.Enter(); }));
+   waiting->start();
+   QThread::msleep(50);
+   gate.Leave();
+
+   QVERIFY(waiting->wait(10000));
+   QVERIFY(admitted);
+}
+
+void AdmissionTest::QueuedRequestTimesOut()
+{
+   AdmissionGate gate(1, 1, 50);
+   QVERIFY(gate.Enter());
+
+   QElapsedTimer timer;
+   timer.start();
+   QVERIFY(!gate.Enter());
+   QVERIFY(timer.elapsed() >= 40);
+}
+
+void AdmissionTest::RefusesWhenQueueIsFull()
+{
+   AdmissionGate gate(1, 1, 10000);
+   QVERIFY(gate.Enter());
+
+   std::atomic<bool> admitted{ false };
+   std::unique_ptr<QThread> waiting(QThread::create([&] { admitted = gate.Enter(); }));
+   waiting->start();
+   QThread::msleep(50);
+
+   QVERIFY(!gate.Enter());   // The queue holds the other request
+
+   gate.Leave();
+   QVERIFY(waiting->wait(10000));
+   QVERIFY(admitted);
+}
+
+void AdmissionTest::SlotLeavesGate()
+{
+   AdmissionGate gate(1, 0, 0);
+   {
+      QVERIFY(gate.Enter());
+      AdmissionGate::Slot slot(&gate);
+      QVERIFY(!gate.Enter());
+   }
+   QVERIFY(gate.Enter());
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::AdmissionTest)
+#include "AdmissionTest.moc"
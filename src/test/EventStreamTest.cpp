@@ -0,0 +1,165 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "EventStream.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of the subscriptions of EventChannel and the event format.
+//!
+//****************************************************************************
+
+class EventStreamTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void NextTakesAllQueued();
+   void NextTimesOut();
+   void SlowSubscriberIsDropped();
+   void PublishSharesEvent();
+   void ChannelLimitsSubscribers();
+   void SubscribersSkipClosed();
+   void CloseEndsSubscriptions();
+   void SerializeFramesChunk();
+};
+
+void EventStreamTest::NextTakesAllQueued()
+{
+   EventSubscription subscription;
+   QVERIFY(subscription.Push(EventChannel::Chunk("a")));
+   QVERIFY(subscription.Push(EventChannel::Chunk("b")));
+   QVERIFY(subscription.Push(EventChannel::Chunk("c")));
+
+   bool ended = true;
+   std::vector<HttpServer::SharedBuffer> events = subscription.Next(1000, ended);
+   QVERIFY(!ended);
+   QCOMPARE(events.size(), std::size_t(3));
+   QVERIFY(*events[0] == "1\r\na\r\n");
+   QVERIFY(*events[2] == "1\r\nc\r\n");
+
+   QVERIFY(subscription.Next(0, ended).empty());
+   QVERIFY(!ended);
+}
+
+void EventStreamTest::NextTimesOut()
+{
+   EventSubscription subscription;
+   bool ended = true;
+   QVERIFY(subscription.Next(10, ended).empty());
+   QVERIFY(!ended);
+}
+
+void EventStreamTest::SlowSubscriberIsDropped()
+{
+   EventSubscription subscription;
+   HttpServer::SharedBuffer event = EventChannel::Chunk("a");
+   for (int i = 0; i < EventSubscription::maxQueued; i++)
+      QVERIFY(subscription.Push(event));
+
+   QVERIFY(!subscription.Push(event));
+   QVERIFY(subscription.IsClosed());
+
+   bool ended = false;
+   QVERIFY(subscription.Next(0, ended).empty());
+   QVERIFY(ended);
+}
+
+void EventStreamTest::PublishSharesEvent()
+{
+   EventChannel channel(2);
+   std::shared_ptr<EventSubscription> first = channel.Subscribe();
+   std::shared_ptr<EventSubscription> second = channel.Subscribe();
+   QVERIFY(first && second);
+
+   HttpServer::SharedBuffer event = EventChannel::Serialize("data", QString(), QString());
+   QCOMPARE(channel.Publish(event), 2);
+
+   bool ended = false;
+   std::vector<HttpServer::SharedBuffer> firstEvents = first->Next(0, ended);
+   std::vector<HttpServer::SharedBuffer> secondEvents = second->Next(0, ended);
+   QCOMPARE(firstEvents.size(), std::size_t(1));
+   QCOMPARE(secondEvents.size(), std::size_t(1));
+   QCOMPARE(firstEvents[0].get(), event.get());
+   QCOMPARE(secondEvents[0].get(), event.get());
+}
+
+void EventStreamTest::ChannelLimitsSubscribers()
+{
+   EventChannel channel(1);
+   std::shared_ptr<EventSubscription> first = channel.Subscribe();
+   QVERIFY(first);
+   QVERIFY(!channel.Subscribe());
+
+   first->Close();
+   QVERIFY(channel.Subscribe());
+}
+
+void EventStreamTest::SubscribersSkipClosed()
+{
+   EventChannel channel(2);
+   std::shared_ptr<EventSubscription> first = channel.Subscribe();
+   std::shared_ptr<EventSubscription> second = channel.Subscribe();
+   QCOMPARE(channel.Subscribers(), 2);
+
+   first->Close();
+   QCOMPARE(channel.Subscribers(), 1);
+
+   channel.Close();
+   QCOMPARE(channel.Subscribers(), 0);
+}
+
+void EventStreamTest::CloseEndsSubscriptions()
+{
+   EventChannel channel(1);
+   std::shared_ptr<EventSubscription> subscription = channel.Subscribe();
+   channel.Close();
+
+   bool ended = false;
+   QVERIFY(subscription->Next(1000, ended).empty());
+   QVERIFY(ended);
+   QVERIFY(!channel.Subscribe());
+   QCOMPARE(channel.Publish(EventChannel::Chunk("a")), 0);
+
+   channel.Open();
+   QVERIFY(channel.Subscribe());
+}
+
+void EventStreamTest::SerializeFramesChunk()
+{
+   HttpServer::SharedBuffer event = EventChannel::Serialize("a\r\nb", "up\ndate", "1");
+   QVERIFY(*event == "25\r\nid: 1\nevent: update\ndata: a\ndata: b\n\n\r\n");
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::EventStreamTest)
+#include "EventStreamTest.moc"
@@ -0,0 +1,157 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "RateLimiter.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#include <string>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of the token buckets and their eviction in RateLimiter.
+//!
+//****************************************************************************
+
+class RateLimiterTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void RefusesAfterBurst();
+   void KeysHaveOwnBuckets();
+   void RefillsOverTime();
+   void EvictsLeastRecentlyUsed();
+   void KeepsRecentlyUsed();
+   void ClientIsAppendedByProxy();
+   void ClientBehindSeveralProxies();
+
+private:
+   static HttpServer::RateLimitOptions Options(double rate, double burst);
+};
+
+//*****************************************************************************
+//! Rate limit by client with the given rate and burst.
+//*****************************************************************************
+HttpServer::RateLimitOptions RateLimiterTest::Options(double rate, double burst)
+{
+   HttpServer::RateLimitOptions options;
+   options.rate = rate;
+   options.burst = burst;
+   options.clientHeader = "X-Forwarded-For";
+   return options;
+}
+
+void RateLimiterTest::RefusesAfterBurst()
+{
+   RateLimiter limiter;
+   limiter.Options(Options(1, 3));
+
+   int retryAfter = 0;
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(!limiter.Allow("a", retryAfter));
+   QCOMPARE(retryAfter, 1);
+   QCOMPARE(limiter.Rejected(), quint64(1));
+}
+
+void RateLimiterTest::KeysHaveOwnBuckets()
+{
+   RateLimiter limiter;
+   limiter.Options(Options(0.001, 1));
+
+   int retryAfter = 0;
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(!limiter.Allow("a", retryAfter));
+   QVERIFY(limiter.Allow("b", retryAfter));
+}
+
+void RateLimiterTest::RefillsOverTime()
+{
+   RateLimiter limiter;
+   limiter.Options(Options(100, 1));
+
+   int retryAfter = 0;
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(!limiter.Allow("a", retryAfter));
+   QThread::msleep(50);
+   QVERIFY(limiter.Allow("a", retryAfter));
+}
+
+void RateLimiterTest::EvictsLeastRecentlyUsed()
+{
+   RateLimiter limiter;
+   limiter.Options(Options(0.001, 1));
+
+   int retryAfter = 0;
+   QVERIFY(limiter.Allow("a", retryAfter));
+   QVERIFY(!limiter.Allow("a", retryAfter));
+
+   // More keys than all shards hold push out the empty bucket, so it starts full again
+   for (int key = 0; key < 64 * 1024; key++)
+      limiter.Allow(std::to_string(key), retryAfter);
+   QVERIFY(limiter.Allow("a", retryAfter));
+}
+
+void RateLimiterTest::KeepsRecentlyUsed()
+{
+   RateLimiter limiter;
+   limiter.Options(Options(0.001, 1));
+
+   int retryAfter = 0;
+   QVERIFY(limiter.Allow("a", retryAfter));
+
+   for (int key = 0; key < 64 * 1024; key++) {
+      limiter.Allow(std::to_string(key), retryAfter);
+      if (key % 64 == 0)
+         QVERIFY(!limiter.Allow("a", retryAfter));
+   }
+   QVERIFY(!limiter.Allow("a", retryAfter));
+}
+
+void RateLimiterTest::ClientIsAppendedByProxy()
+{
+   QVERIFY(RateLimiter::Client("10.0.0.1", 1) == "10.0.0.1");
+   QVERIFY(RateLimiter::Client("forged, 10.0.0.1", 1) == "10.0.0.1");
+   QVERIFY(RateLimiter::Client("a,b ,  10.0.0.1 ", 1) == "10.0.0.1");
+   QVERIFY(RateLimiter::Client("", 1).empty());
+}
+
+void RateLimiterTest::ClientBehindSeveralProxies()
+{
+   QVERIFY(RateLimiter::Client("forged, 10.0.0.1, 10.0.0.2", 2) == "10.0.0.1");
+   QVERIFY(RateLimiter::Client("10.0.0.1, 10.0.0.2", 3) == "10.0.0.1");
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::RateLimiterTest)
+#include "RateLimiterTest.moc"
@@ -0,0 +1,170 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "ResponseCache.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#include <map>
+#include <string>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of which requests and responses the ResponseCache shares.
+//!
+//****************************************************************************
+
+class ResponseCacheTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void PlainRequestIsShared();
+   void AuthorizationIsNotShared();
+   void CookieIsNotShared();
+   void KeyedCredentialsAreShared();
+   void PlainResponseIsStored();
+   void SetCookieIsNotStored();
+   void PrivateIsNotStored();
+   void NoStoreIsNotStored();
+   void VaryIsNotStored();
+   void VaryAcceptEncodingIsStored();
+
+private:
+   //! GET request with headers only, header names are case-insensitive.
+   class Request : public HttpServer::HttpRequestView
+   {
+   public:
+      explicit Request(std::map<std::string, std::string> headers = {}) : headers(std::move(headers)) {}
+
+      HttpServer::ProtocolVersion Version() const override { return HttpServer::HTTP_1_1; }
+      HttpServer::HttpMethod Method() const override { return HttpServer::GET; }
+      std::string_view Path() const override { return "/a"; }
+      std::string_view QueryString() const override { return std::string_view(); }
+      std::string_view Query(std::string_view, bool* found) const override { return None(found); }
+      std::string_view Header(std::string_view name, bool* found) const override;
+      std::string_view PathVariable(std::string_view, bool* found) const override { return None(found); }
+      std::string_view MultiLevel() const override { return std::string_view(); }
+      QByteArrayView Body() const override { return QByteArrayView(); }
+      QString Url() const override { return "/a"; }
+      HttpServer::PathInfo ToPathInfo() const override { return HttpServer::PathInfo(); }
+      HttpServer::HttpRequest ToRequest() const override { return HttpServer::HttpRequest{ HttpServer::HTTP_1_1, HttpServer::GET }; }
+
+   private:
+      static std::string_view None(bool* found) { if (found) *found = false; return std::string_view(); }
+
+      std::map<std::string, std::string> headers;
+   };
+
+   static HttpServer::HttpResponse Response(const QHash<QString, QString>& headers);
+};
+
+std::string_view ResponseCacheTest::Request::Header(std::string_view name, bool* found) const
+{
+   for (const auto& [header, value] : headers) {
+      if (QByteArrayView(header).compare(QByteArrayView(name), Qt::CaseInsensitive) == 0) {
+         if (found)
+            *found = true;
+         return value;
+      }
+   }
+   return None(found);
+}
+
+//*****************************************************************************
+//! 200 response with a body and #headers.
+//*****************************************************************************
+HttpServer::HttpResponse ResponseCacheTest::Response(const QHash<QString, QString>& headers)
+{
+   HttpServer::HttpResponse response;
+   response.statusCode = 200;
+   response.headers = headers;
+   response.body = "body";
+   return response;
+}
+
+void ResponseCacheTest::PlainRequestIsShared()
+{
+   QVERIFY(!ResponseCache::CarriesCredentials(Request({ { "Accept", "*/*" } })));
+}
+
+void ResponseCacheTest::AuthorizationIsNotShared()
+{
+   QVERIFY(ResponseCache::CarriesCredentials(Request({ { "Authorization", "Bearer a" } })));
+}
+
+void ResponseCacheTest::CookieIsNotShared()
+{
+   QVERIFY(ResponseCache::CarriesCredentials(Request({ { "cookie", "session=a" } })));
+}
+
+void ResponseCacheTest::KeyedCredentialsAreShared()
+{
+   Request request({ { "Authorization", "Bearer a" } });
+   QVERIFY(!ResponseCache::CarriesCredentials(request, { "authorization" }));
+   QVERIFY(ResponseCache::CarriesCredentials(Request({ { "Authorization", "Bearer a" }, { "Cookie", "session=a" } }), { "Authorization" }));
+}
+
+void ResponseCacheTest::PlainResponseIsStored()
+{
+   QVERIFY(ResponseCache::Storable(Response({ { "Content-Type", "text/plain" }, { "Cache-Control", "max-age=60" } })));
+}
+
+void ResponseCacheTest::SetCookieIsNotStored()
+{
+   QVERIFY(!ResponseCache::Storable(Response({ { "set-cookie", "session=a" } })));
+}
+
+void ResponseCacheTest::PrivateIsNotStored()
+{
+   QVERIFY(!ResponseCache::Storable(Response({ { "Cache-Control", "max-age=60, private" } })));
+   QVERIFY(!ResponseCache::Storable(Response({ { "Cache-Control", "private=\"Set-Cookie\"" } })));
+}
+
+void ResponseCacheTest::NoStoreIsNotStored()
+{
+   QVERIFY(!ResponseCache::Storable(Response({ { "Cache-Control", "no-store" } })));
+   QVERIFY(!ResponseCache::Storable(Response({ { "cache-control", "No-Cache" } })));
+}
+
+void ResponseCacheTest::VaryIsNotStored()
+{
+   QVERIFY(!ResponseCache::Storable(Response({ { "Vary", "Accept-Encoding, Cookie" } })));
+   QVERIFY(!ResponseCache::Storable(Response({ { "Vary", "*" } })));
+}
+
+void ResponseCacheTest::VaryAcceptEncodingIsStored()
+{
+   QVERIFY(ResponseCache::Storable(Response({ { "Vary", "Accept-Encoding" } })));
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::ResponseCacheTest)
+#include "ResponseCacheTest.moc"
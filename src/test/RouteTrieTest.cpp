@@ -0,0 +1,191 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "RouteTrie.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of the ambiguity and specificity rules of RouteTrie.
+//!
+//****************************************************************************
+
+class RouteTrieTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void VariableNamesAreAmbiguous();
+   void MethodsAreNotAmbiguous();
+   void MultiLevelWildcardsAreAmbiguous();
+   void RemovedEndpointIsNotAmbiguous();
+   void LiteralWinsOverVariable();
+   void FewerVariablesWin();
+   void VariablesWinOverMultiLevel();
+   void MultiLevelMatchesRemainingPath();
+   void MethodWinsOverAll();
+   void MethodNotAllowed();
+   void CopiesAreIndependent();
+
+private:
+   static QString Find(const RouteTrie& trie, std::string_view path, HttpServer::HttpMethod method = HttpServer::GET);
+};
+
+//*****************************************************************************
+//! The matched endpoint, or the name of the lookup result if none matched.
+//*****************************************************************************
+QString RouteTrieTest::Find(const RouteTrie& trie, std::string_view path, HttpServer::HttpMethod method)
+{
+   RouteTrie::Match match;
+   switch (trie.Find(path, method, match)) {
+      case RouteTrie::Found: return match.route->endpoint;
+      case RouteTrie::MethodNotAllowed: return "MethodNotAllowed";
+      default: return "NotFound";
+   }
+}
+
+void RouteTrieTest::VariableNamesAreAmbiguous()
+{
+   RouteTrie trie;
+   QVERIFY(trie.Insert("/a/{x}", HttpServer::GET).isNull());
+   QCOMPARE(trie.Insert("/a/{y}", HttpServer::GET), QString("/a/{x}"));
+   QCOMPARE(trie.Count(), 1);
+}
+
+void RouteTrieTest::MethodsAreNotAmbiguous()
+{
+   RouteTrie trie;
+   QVERIFY(trie.Insert("/a/{x}", HttpServer::GET).isNull());
+   QVERIFY(trie.Insert("/a/{y}", HttpServer::POST).isNull());
+   QVERIFY(trie.Insert("/a/{z}", HttpServer::ALL).isNull());
+   QCOMPARE(trie.Count(), 3);
+}
+
+void RouteTrieTest::MultiLevelWildcardsAreAmbiguous()
+{
+   RouteTrie trie;
+   QVERIFY(trie.Insert("/a/#", HttpServer::GET).isNull());
+   QCOMPARE(trie.Insert("/a/#", HttpServer::GET), QString("/a/#"));
+   QVERIFY(trie.Insert("/a/{x}", HttpServer::GET).isNull());   // Matches one level only
+   QVERIFY(trie.Insert("/a/{x}/#", HttpServer::GET).isNull());
+}
+
+void RouteTrieTest::RemovedEndpointIsNotAmbiguous()
+{
+   RouteTrie trie;
+   QVERIFY(trie.Insert("/a/{x}", HttpServer::GET).isNull());
+   QVERIFY(!trie.Remove("/a/{y}", HttpServer::GET));   // Removed by the registered name only
+   QVERIFY(trie.Remove("/a/{x}", HttpServer::GET));
+   QVERIFY(trie.Insert("/a/{y}", HttpServer::GET).isNull());
+   QCOMPARE(trie.Count(), 1);
+}
+
+void RouteTrieTest::LiteralWinsOverVariable()
+{
+   RouteTrie trie;
+   trie.Insert("/a/{x}", HttpServer::GET);
+   trie.Insert("/a/b", HttpServer::GET);
+   QCOMPARE(Find(trie, "/a/b"), QString("/a/b"));
+   QCOMPARE(Find(trie, "/a/c"), QString("/a/{x}"));
+
+   RouteTrie::Match match;
+   QCOMPARE(trie.Find("/a/c", HttpServer::GET, match), RouteTrie::Found);
+   QCOMPARE(match.variables.size(), 1);
+   QVERIFY(match.variables[0] == "c");
+}
+
+void RouteTrieTest::FewerVariablesWin()
+{
+   RouteTrie trie;
+   trie.Insert("/{x}/{y}", HttpServer::GET);
+   trie.Insert("/{x}/b", HttpServer::GET);
+   trie.Insert("/a/{y}", HttpServer::GET);
+   QCOMPARE(Find(trie, "/c/d"), QString("/{x}/{y}"));
+   QCOMPARE(Find(trie, "/c/b"), QString("/{x}/b"));
+   QCOMPARE(Find(trie, "/a/d"), QString("/a/{y}"));
+   QCOMPARE(Find(trie, "/a/b"), QString("/a/{y}"));   // Equal levels, the literal prefix is visited first
+}
+
+void RouteTrieTest::VariablesWinOverMultiLevel()
+{
+   RouteTrie trie;
+   trie.Insert("/a/#", HttpServer::GET);
+   trie.Insert("/a/{x}", HttpServer::GET);
+   trie.Insert("/a/{x}/{y}", HttpServer::GET);
+   QCOMPARE(Find(trie, "/a/b"), QString("/a/{x}"));
+   QCOMPARE(Find(trie, "/a/b/c"), QString("/a/{x}/{y}"));
+   QCOMPARE(Find(trie, "/a/b/c/d"), QString("/a/#"));
+}
+
+void RouteTrieTest::MultiLevelMatchesRemainingPath()
+{
+   RouteTrie trie;
+   trie.Insert("/files/#", HttpServer::GET);
+
+   RouteTrie::Match match;
+   QCOMPARE(trie.Find("/files/css/site.css", HttpServer::GET, match), RouteTrie::Found);
+   QVERIFY(match.multiLevel == "/css/site.css");
+   QCOMPARE(Find(trie, "/files"), QString("NotFound"));
+}
+
+void RouteTrieTest::MethodWinsOverAll()
+{
+   RouteTrie trie;
+   trie.Insert("/a/b", HttpServer::ALL);
+   trie.Insert("/a/{x}", HttpServer::GET);
+   QCOMPARE(Find(trie, "/a/b", HttpServer::GET), QString("/a/{x}"));   // Even if the ALL route is more specific
+   QCOMPARE(Find(trie, "/a/b", HttpServer::POST), QString("/a/b"));
+}
+
+void RouteTrieTest::MethodNotAllowed()
+{
+   RouteTrie trie;
+   trie.Insert("/a/{x}", HttpServer::GET);
+   QCOMPARE(Find(trie, "/a/b", HttpServer::POST), QString("MethodNotAllowed"));
+   QCOMPARE(Find(trie, "/b", HttpServer::GET), QString("NotFound"));
+}
+
+void RouteTrieTest::CopiesAreIndependent()
+{
+   RouteTrie trie;
+   trie.Insert("/a/{x}", HttpServer::GET);
+
+   RouteTrie copy(trie);
+   QVERIFY(copy.Remove("/a/{x}", HttpServer::GET));
+   QVERIFY(copy.Insert("/a/b", HttpServer::GET).isNull());
+
+   QCOMPARE(Find(trie, "/a/b"), QString("/a/{x}"));
+   QCOMPARE(Find(copy, "/a/c"), QString("NotFound"));
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::RouteTrieTest)
+#include "RouteTrieTest.moc"
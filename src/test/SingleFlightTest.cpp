@@ -0,0 +1,218 @@
+//*****************************************************************************
+//
+// Copyright (C) 2024 SICK AG
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 3 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to SICK AG, Erwin-Sick-Str. 1,
+// 79183 Waldkirch.
+//!
+//*****************************************************************************
+
+#include "Global.h"
+#include "SingleFlight.h"
+
+#pragma push_macro("new")
+#undef new
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+#pragma pop_macro("new")
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+
+namespace mau {
+
+//****************************************************************************
+//!
+//! \brief Tests of coalescing concurrent requests with SingleFlight.
+//!
+//****************************************************************************
+
+class SingleFlightTest : public QObject
+{
+   Q_OBJECT
+
+private slots:
+   void SharesResponseOfCallInFlight();
+   void KeysAreIndependent();
+   void SequentialRequestsCallAgain();
+   void FailedFlightIsTakenOverOnce();
+   void WaitTimesOut();
+
+private:
+   struct Request {
+      bool completed = false;
+      bool shared = false;
+      HttpServer::HttpResponse response;
+      std::unique_ptr<QThread> thread;
+   };
+
+   static void Start(SingleFlight& flights, const QByteArray& key, const SingleFlight::Handler& handler, int timeout, Request& request);
+   static SingleFlight::Handler Respond(std::atomic<int>& calls, const QByteArray& body, QSemaphore* release = nullptr);
+};
+
+//*****************************************************************************
+//! Runs a request on a thread of its own.
+//*****************************************************************************
+void SingleFlightTest::Start(SingleFlight& flights, const QByteArray& key, const SingleFlight::Handler& handler, int timeout, Request& request)
+{
+   request.thread.reset(QThread::create([&flights, key, handler, timeout, &request] {
+      request.completed = flights.Run(key, handler, timeout, request.response, request.shared);
+   }));
+   request.thread->start();
+}
+
+//*****************************************************************************
+//! Handler counting its calls and answering with #body, after #release was
+//! released if given.
+//*****************************************************************************
+SingleFlight::Handler SingleFlightTest::Respond(std::atomic<int>& calls, const QByteArray& body, QSemaphore* release)
+{
+   return [&calls, body, release](HttpServer::HttpResponse& response) {
+      calls++;
+      if (release)
+         release->acquire();
+      response.statusCode = 200;
+      response.body = body;
+      return true;
+   };
+}
+
+void SingleFlightTest::SharesResponseOfCallInFlight()
+{
+   SingleFlight flights;
+   std::atomic<int> calls{ 0 };
+   QSemaphore release;
+
+   Request leader, waiter;
+   Start(flights, "key", Respond(calls, "first", &release), 10000, leader);
+   QTRY_COMPARE(calls.load(), 1);
+   Start(flights, "key", Respond(calls, "second"), 10000, waiter);
+   QThread::msleep(50);
+   release.release();
+
+   QVERIFY(leader.thread->wait(10000));
+   QVERIFY(waiter.thread->wait(10000));
+   QCOMPARE(calls.load(), 1);
+   QVERIFY(leader.completed && !leader.shared);
+   QVERIFY(waiter.completed && waiter.shared);
+   QCOMPARE(waiter.response.body, QByteArray("first"));
+}
+
+void SingleFlightTest::KeysAreIndependent()
+{
+   SingleFlight flights;
+   std::atomic<int> calls{ 0 };
+   QSemaphore release;
+
+   Request leader;
+   Start(flights, "a", Respond(calls, "a", &release), 10000, leader);
+   QTRY_COMPARE(calls.load(), 1);
+
+   HttpServer::HttpResponse response;
+   bool shared = true;
+   QVERIFY(flights.Run("b", Respond(calls, "b"), 10000, response, shared));
+   QVERIFY(!shared);
+   QCOMPARE(response.body, QByteArray("b"));
+
+   release.release();
+   QVERIFY(leader.thread->wait(10000));
+}
+
+void SingleFlightTest::SequentialRequestsCallAgain()
+{
+   SingleFlight flights;
+   std::atomic<int> calls{ 0 };
+
+   HttpServer::HttpResponse response;
+   bool shared = true;
+   QVERIFY(flights.Run("key", Respond(calls, "first"), 10000, response, shared));
+   QVERIFY(flights.Run("key", Respond(calls, "second"), 10000, response, shared));
+   QVERIFY(!shared);
+   QCOMPARE(response.body, QByteArray("second"));
+   QCOMPARE(calls.load(), 2);
+}
+
+void SingleFlightTest::FailedFlightIsTakenOverOnce()
+{
+   SingleFlight flights;
+   std::atomic<int> calls{ 0 };
+   QSemaphore release;
+
+   SingleFlight::Handler fail = [&](HttpServer::HttpResponse&) {
+      calls++;
+      release.acquire();
+      return false;
+   };
+   SingleFlight::Handler slow = [&](HttpServer::HttpResponse& response) {
+      calls++;
+      QThread::msleep(100);   // Keeps the flight open until the other waiters are woken
+      response.statusCode = 200;
+      response.body = "retry";
+      return true;
+   };
+
+   Request leader;
+   Start(flights, "key", fail, 10000, leader);
+   QTRY_COMPARE(calls.load(), 1);
+
+   std::vector<Request> waiters(4);
+   for (Request& waiter : waiters)
+      Start(flights, "key", slow, 10000, waiter);
+   QThread::msleep(50);
+   release.release();
+
+   QVERIFY(leader.thread->wait(10000));
+   QVERIFY(!leader.completed);
+
+   int shared = 0;
+   for (Request& waiter : waiters) {
+      QVERIFY(waiter.thread->wait(10000));
+      QVERIFY(waiter.completed);
+      QCOMPARE(waiter.response.body, QByteArray("retry"));
+      shared += waiter.shared;
+   }
+   QCOMPARE(calls.load(), 2);
+   QCOMPARE(shared, int(waiters.size()) - 1);
+}
+
+void SingleFlightTest::WaitTimesOut()
+{
+   SingleFlight flights;
+   std::atomic<int> calls{ 0 };
+   QSemaphore release;
+
+   Request leader;
+   Start(flights, "key", Respond(calls, "first", &release), 10000, leader);
+   QTRY_COMPARE(calls.load(), 1);
+
+   HttpServer::HttpResponse response;
+   bool shared = true;
+   QVERIFY(!flights.Run("key", Respond(calls, "second"), 50, response, shared));
+   QVERIFY(!shared);
+   QCOMPARE(calls.load(), 1);
+
+   release.release();
+   QVERIFY(leader.thread->wait(10000));
+   QVERIFY(leader.completed);
+}
+
+}
+
+QTEST_GUILESS_MAIN(mau::SingleFlightTest)
+#include "SingleFlightTest.moc"